@@ -0,0 +1,291 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BuildVisibilityGridCommandlet.h"
+#include "ShootingGame.h"
+#include "VisibilityGridData.h"
+#include "Engine/World.h"
+#include "Engine/LevelBounds.h"
+#include "Misc/PackageName.h"
+
+/** Grids larger than this get coarser cells, keeping the bit matrix at a few megabytes */
+static const int32 VisibilityGridMaxCells = 8192;
+
+/** Steepest surface counted as a floor, about the character's walkable angle */
+static const float VisibilityGridWalkableFloorZ = 0.71f;
+
+/** How far under a surface the floor probe restarts */
+static const float VisibilityGridFloorSkip = 5.0f;
+
+#if WITH_EDITOR
+/** Heights of every walkable surface under Point, top down, at most MaxFloors */
+static void FindFloors(UWorld* World, const FVector2D& Point, float TopZ, float BottomZ, int32 MaxFloors, const FCollisionQueryParams& QueryParams, TArray<float>& OutFloors)
+{
+	OutFloors.Reset();
+
+	float StartZ = TopZ;
+	for (int32 i = 0; i < MaxFloors * 4 && OutFloors.Num() < MaxFloors && StartZ > BottomZ; ++i)
+	{
+		FHitResult Hit;
+		if (World->LineTraceSingleByChannel(Hit, FVector(Point, StartZ), FVector(Point, BottomZ), ECC_Visibility, QueryParams) == false)
+			break;
+
+		// Roofs, bridges and upper floors all count; walls and slopes nobody stands on do not
+		if (Hit.bStartPenetrating == false && Hit.ImpactNormal.Z >= VisibilityGridWalkableFloorZ)
+		{
+			OutFloors.Add(Hit.ImpactPoint.Z);
+		}
+
+		// Complex traces skip back faces, so restarting just under the surface passes through the slab to the next level
+		StartZ = Hit.ImpactPoint.Z - VisibilityGridFloorSkip;
+	}
+}
+#endif
+
+UBuildVisibilityGridCommandlet::UBuildVisibilityGridCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UBuildVisibilityGridCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	FString MapName;
+	if (FParse::Value(*Params, TEXT("Map="), MapName) == false)
+	{
+		UE_LOG(LogShootingGame, Error, TEXT("BuildVisibilityGrid: missing -Map=/Game/Path/To/Map"));
+		return 1;
+	}
+
+	float CellSize = 400.0f;
+	FString EyeHeightList = TEXT("90,160,260");
+	int32 MaxFloors = 4;
+	float MaxDistance = 15000.0f;
+	int32 Dilation = 1;
+	FParse::Value(*Params, TEXT("CellSize="), CellSize);
+	FParse::Value(*Params, TEXT("EyeHeights="), EyeHeightList);
+	FParse::Value(*Params, TEXT("MaxFloors="), MaxFloors);
+	FParse::Value(*Params, TEXT("MaxDistance="), MaxDistance);
+	FParse::Value(*Params, TEXT("Dilation="), Dilation);
+
+	// Crouched, standing, and jumping or standing on a prop
+	TArray<FString> EyeHeightStrings;
+	EyeHeightList.ParseIntoArray(EyeHeightStrings, TEXT(","));
+	TArray<float> EyeHeights;
+	for (const FString& Height : EyeHeightStrings)
+	{
+		EyeHeights.Add(FCString::Atof(*Height));
+	}
+	if (EyeHeights.Num() == 0 || MaxFloors < 1)
+	{
+		UE_LOG(LogShootingGame, Error, TEXT("BuildVisibilityGrid: needs at least one eye height and one floor per column"));
+		return 1;
+	}
+
+	UPackage* MapPackage = LoadPackage(nullptr, *MapName, LOAD_None);
+	UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : nullptr;
+	if (World == nullptr)
+	{
+		UE_LOG(LogShootingGame, Error, TEXT("BuildVisibilityGrid: could not load map %s"), *MapName);
+		return 1;
+	}
+
+	// Traces need an initialized world with registered collision
+	World->AddToRoot();
+	World->WorldType = EWorldType::Editor;
+	if (World->bIsWorldInitialized == false)
+	{
+		World->InitWorld(UWorld::InitializationValues()
+			.RequiresHitProxies(false)
+			.ShouldSimulatePhysics(false)
+			.EnableTraceCollision(true)
+			.CreateNavigation(false)
+			.CreateAISystem(false)
+			.AllowAudioPlayback(false)
+			.CreatePhysicsScene(true));
+	}
+	World->UpdateWorldComponents(true, false);
+
+	const FBox Bounds = ALevelBounds::CalculateLevelBounds(World->PersistentLevel);
+	if (Bounds.IsValid == false)
+	{
+		UE_LOG(LogShootingGame, Error, TEXT("BuildVisibilityGrid: %s has no bounds"), *MapName);
+		World->RemoveFromRoot();
+		return 1;
+	}
+
+	const FVector Size = Bounds.GetSize();
+	CellSize = FMath::Max(CellSize, FMath::Sqrt(Size.X * Size.Y / VisibilityGridMaxCells));
+	const int32 SizeX = FMath::Max(1, FMath::CeilToInt(Size.X / CellSize));
+	const int32 SizeY = FMath::Max(1, FMath::CeilToInt(Size.Y / CellSize));
+	const int32 NumCells = SizeX * SizeY;
+
+	const FString GridPackageName = UVisibilityGridData::GetPackageNameForMap(MapName);
+	UPackage* GridPackage = CreatePackage(*GridPackageName);
+	UVisibilityGridData* Grid = NewObject<UVisibilityGridData>(GridPackage, *FPackageName::GetShortName(GridPackageName), RF_Public | RF_Standalone);
+	Grid->Init(FVector2D(Bounds.Min), CellSize, SizeX, SizeY);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(BuildVisibilityGrid), false);
+	FCollisionQueryParams FloorQueryParams(SCENE_QUERY_STAT(BuildVisibilityGridFloor), true);
+
+	// Eye points per cell: every offset, on every floor under it, at every eye height with headroom. Cells without any floor nobody can stand in.
+	const int32 OffsetsPerCell = 5;
+	const FVector2D SampleOffsets[OffsetsPerCell] = { FVector2D(0.0f, 0.0f), FVector2D(-0.25f, -0.25f), FVector2D(0.25f, -0.25f), FVector2D(-0.25f, 0.25f), FVector2D(0.25f, 0.25f) };
+
+	TArray<FVector> Samples;
+	TArray<int32> FirstSample;
+	TArray<bool> HasFloor;
+	TArray<float> Floors;
+	FirstSample.SetNumUninitialized(NumCells + 1);
+	HasFloor.Init(false, NumCells);
+
+	int32 NumMultiLevelCells = 0;
+	for (int32 Cell = 0; Cell < NumCells; ++Cell)
+	{
+		FirstSample[Cell] = Samples.Num();
+
+		int32 CellLevels = 0;
+		const FVector2D Center = Grid->Origin + FVector2D((Cell % SizeX) + 0.5f, (Cell / SizeX) + 0.5f) * CellSize;
+		for (int32 s = 0; s < OffsetsPerCell; ++s)
+		{
+			const FVector2D Point = Center + SampleOffsets[s] * CellSize;
+			FindFloors(World, Point, Bounds.Max.Z, Bounds.Min.Z, MaxFloors, FloorQueryParams, Floors);
+			CellLevels = FMath::Max(CellLevels, Floors.Num());
+
+			for (float FloorZ : Floors)
+			{
+				for (float Height : EyeHeights)
+				{
+					// A low ceiling rules out standing or jumping there, not crouching
+					if (World->LineTraceTestByChannel(FVector(Point, FloorZ + 1.0f), FVector(Point, FloorZ + Height), ECC_Visibility, QueryParams) == false)
+					{
+						Samples.Add(FVector(Point, FloorZ + Height));
+					}
+				}
+			}
+		}
+
+		HasFloor[Cell] = Samples.Num() > FirstSample[Cell];
+		NumMultiLevelCells += CellLevels > 1 ? 1 : 0;
+	}
+	FirstSample[NumCells] = Samples.Num();
+
+	UE_LOG(LogShootingGame, Display, TEXT("BuildVisibilityGrid: %d eye points, %d cells with more than one level"), Samples.Num(), NumMultiLevelCells);
+
+	// Raw cell-to-cell visibility, symmetric, first sample pair with a clear line wins. Levels and heights are OR-ed together.
+	UVisibilityGridData* Raw = NewObject<UVisibilityGridData>();
+	Raw->Init(Grid->Origin, CellSize, SizeX, SizeY);
+
+	int64 NumTraces = 0;
+	for (int32 From = 0; From < NumCells; ++From)
+	{
+		Raw->SetCellVisible(From, From);
+		if (HasFloor[From] == false)
+			continue;
+
+		for (int32 To = From + 1; To < NumCells; ++To)
+		{
+			if (HasFloor[To] == false)
+				continue;
+
+			const int32 DX = (To % SizeX) - (From % SizeX);
+			const int32 DY = (To / SizeX) - (From / SizeX);
+			if (FMath::Square(DX * CellSize) + FMath::Square(DY * CellSize) > FMath::Square(MaxDistance + CellSize))
+				continue;
+
+			bool bVisible = false;
+			for (int32 a = FirstSample[From]; a < FirstSample[From + 1] && bVisible == false; ++a)
+			{
+				for (int32 b = FirstSample[To]; b < FirstSample[To + 1] && bVisible == false; ++b)
+				{
+					++NumTraces;
+					bVisible = World->LineTraceTestByChannel(Samples[a], Samples[b], ECC_Visibility, QueryParams) == false;
+				}
+			}
+
+			if (bVisible)
+			{
+				Raw->SetCellVisible(From, To);
+				Raw->SetCellVisible(To, From);
+			}
+		}
+
+		if (From % SizeX == 0)
+		{
+			UE_LOG(LogShootingGame, Display, TEXT("BuildVisibilityGrid: row %d / %d"), From / SizeX, SizeY);
+		}
+	}
+
+	// Cells without floor stay visible both ways, so anything flying or falling through them is never culled
+	for (int32 Cell = 0; Cell < NumCells; ++Cell)
+	{
+		if (HasFloor[Cell])
+			continue;
+
+		for (int32 Other = 0; Other < NumCells; ++Other)
+		{
+			Raw->SetCellVisible(Cell, Other);
+			Raw->SetCellVisible(Other, Cell);
+		}
+	}
+
+	// Dilate the viewer end by OR-ing the rows of neighbouring cells, then the target end by spreading every set bit
+	const int32 Words = Grid->GetWordsPerCell();
+	TArray<uint32> Dilated;
+	Dilated.SetNumUninitialized(Words);
+
+	for (int32 From = 0; From < NumCells; ++From)
+	{
+		FMemory::Memzero(Dilated.GetData(), Words * sizeof(uint32));
+
+		const int32 fx = From % SizeX;
+		const int32 fy = From / SizeX;
+		for (int32 y = FMath::Max(0, fy - Dilation); y <= FMath::Min(SizeY - 1, fy + Dilation); ++y)
+		{
+			for (int32 x = FMath::Max(0, fx - Dilation); x <= FMath::Min(SizeX - 1, fx + Dilation); ++x)
+			{
+				const uint32* Row = Raw->GetRow(y * SizeX + x);
+				for (int32 w = 0; w < Words; ++w)
+				{
+					Dilated[w] |= Row[w];
+				}
+			}
+		}
+
+		for (int32 To = 0; To < NumCells; ++To)
+		{
+			if ((Dilated[To >> 5] & (1u << (To & 31))) == 0)
+				continue;
+
+			const int32 tx = To % SizeX;
+			const int32 ty = To / SizeX;
+			for (int32 y = FMath::Max(0, ty - Dilation); y <= FMath::Min(SizeY - 1, ty + Dilation); ++y)
+			{
+				for (int32 x = FMath::Max(0, tx - Dilation); x <= FMath::Min(SizeX - 1, tx + Dilation); ++x)
+				{
+					Grid->SetCellVisible(From, y * SizeX + x);
+				}
+			}
+		}
+	}
+
+	World->RemoveFromRoot();
+
+	GridPackage->MarkPackageDirty();
+	const FString Filename = FPackageName::LongPackageNameToFilename(GridPackageName, FPackageName::GetAssetPackageExtension());
+	if (UPackage::SavePackage(GridPackage, Grid, RF_Public | RF_Standalone, *Filename) == false)
+	{
+		UE_LOG(LogShootingGame, Error, TEXT("BuildVisibilityGrid: failed to save %s"), *Filename);
+		return 1;
+	}
+
+	UE_LOG(LogShootingGame, Display, TEXT("BuildVisibilityGrid: %s, %d x %d cells of %.0f, %lld traces"), *Filename, SizeX, SizeY, CellSize, NumTraces);
+	return 0;
+#else
+	UE_LOG(LogShootingGame, Error, TEXT("BuildVisibilityGrid needs an editor build"));
+	return 1;
+#endif
+}
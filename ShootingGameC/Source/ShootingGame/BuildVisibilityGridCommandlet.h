@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "BuildVisibilityGridCommandlet.generated.h"
+
+/**
+ * Builds the UVisibilityGridData of a map from eye-height line traces between grid cells.
+ *
+ * UE4Editor-Cmd.exe ShootingGame.uproject -run=BuildVisibilityGrid -Map=/Game/ThirdPersonCPP/Maps/ThirdPersonExampleMap
+ *   [-CellSize=400] [-EyeHeights=90,160,260] [-MaxFloors=4] [-MaxDistance=15000] [-Dilation=1]
+ *
+ * Each cell is sampled at its center and four inner points, on every walkable level under them (ground, upper floors,
+ * bridges, roofs), at every eye height that fits under the ceiling: crouched, standing, and jumping or standing on props.
+ * Two cells see each other if any pair of samples does, so a cell stacked over another gets the union of both levels.
+ * The result is then dilated by Dilation cells on both ends, so peeking around a corner is covered before the
+ * viewer actually crosses into the next cell. Only the persistent level is traced.
+ */
+UCLASS()
+class UBuildVisibilityGridCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UBuildVisibilityGridCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,162 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CharacterSpatialIndex.h"
+#include "ShootingGame.h"
+
+DECLARE_CYCLE_STAT(TEXT("Spatial Index Update"), STAT_SpatialIndexUpdate, STATGROUP_ShootingGame);
+
+static const int32 SpatialIndexBuckets = 4096;
+static const float SpatialIndexCellSize = 1000.0f;
+static const float SpatialIndexHistoryInterval = 1.0f / 60.0f;
+
+void UCharacterSpatialIndex::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	BucketHeads.Init(INDEX_NONE, SpatialIndexBuckets);
+	NumCharacters = 0;
+	InvCellSize = 1.0f / SpatialIndexCellSize;
+}
+
+int32 UCharacterSpatialIndex::Add(AShootingGameCharacter* Char, const FVector& Location)
+{
+	int32 Handle;
+	if (FreeEntries.Num() > 0)
+	{
+		Handle = FreeEntries.Pop(false);
+	}
+	else
+	{
+		Handle = Entries.AddUninitialized();
+		Histories.AddUninitialized();
+	}
+
+	FEntry& Entry = Entries[Handle];
+	Entry.Location = Location;
+	Entry.Char = Char;
+	Entry.Cell = GetCell(Location);
+	Link(Handle);
+
+	Histories[Handle].Head = 0;
+	Histories[Handle].Num = 0;
+	Record(Handle, Location);
+
+	++NumCharacters;
+	return Handle;
+}
+
+void UCharacterSpatialIndex::Remove(int32 Handle)
+{
+	if (Entries.IsValidIndex(Handle) == false || Entries[Handle].Char == nullptr)
+		return;
+
+	Unlink(Handle);
+	Entries[Handle].Char = nullptr;
+	FreeEntries.Push(Handle);
+
+	--NumCharacters;
+}
+
+void UCharacterSpatialIndex::Update(int32 Handle, const FVector& Location)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpatialIndexUpdate);
+
+	FEntry& Entry = Entries[Handle];
+	Entry.Location = Location;
+	Record(Handle, Location);
+
+	const FIntPoint Cell = GetCell(Location);
+	if (Cell != Entry.Cell)
+	{
+		Unlink(Handle);
+		Entry.Cell = Cell;
+		Link(Handle);
+	}
+}
+
+void UCharacterSpatialIndex::Link(int32 Handle)
+{
+	FEntry& Entry = Entries[Handle];
+	int32& Head = BucketHeads[GetBucket(Entry.Cell)];
+
+	Entry.Prev = INDEX_NONE;
+	Entry.Next = Head;
+	if (Head != INDEX_NONE)
+	{
+		Entries[Head].Prev = Handle;
+	}
+	Head = Handle;
+}
+
+void UCharacterSpatialIndex::Unlink(int32 Handle)
+{
+	FEntry& Entry = Entries[Handle];
+
+	if (Entry.Prev != INDEX_NONE)
+	{
+		Entries[Entry.Prev].Next = Entry.Next;
+	}
+	else
+	{
+		BucketHeads[GetBucket(Entry.Cell)] = Entry.Next;
+	}
+
+	if (Entry.Next != INDEX_NONE)
+	{
+		Entries[Entry.Next].Prev = Entry.Prev;
+	}
+}
+
+void UCharacterSpatialIndex::Record(int32 Handle, const FVector& Location)
+{
+	FHistory& History = Histories[Handle];
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	if (History.Num > 0 && History.Times[History.Head] >= Now)
+	{
+		History.Locations[History.Head] = Location;
+		return;
+	}
+
+	// Until the newest sample is HistoryInterval past the one before it, it moves forward instead of taking a new slot
+	const int32 Prev = (History.Head - 1 + HistorySize) % HistorySize;
+	if (History.Num > 1 && Now - History.Times[Prev] < SpatialIndexHistoryInterval)
+	{
+		History.Locations[History.Head] = Location;
+		History.Times[History.Head] = Now;
+		return;
+	}
+
+	History.Head = (History.Head + 1) % HistorySize;
+	History.Locations[History.Head] = Location;
+	History.Times[History.Head] = Now;
+	History.Num = FMath::Min(History.Num + 1, HistorySize);
+}
+
+float UCharacterSpatialIndex::GetHistoryDuration()
+{
+	return (HistorySize - 2) * SpatialIndexHistoryInterval;
+}
+
+FVector UCharacterSpatialIndex::GetLocationAtTime(int32 Handle, float Time) const
+{
+	const FHistory& History = Histories[Handle];
+
+	// Walk back from the newest sample until the pair that brackets Time
+	int32 Newer = History.Head;
+	for (int32 i = 1; i < History.Num; ++i)
+	{
+		const int32 Older = (History.Head - i + HistorySize) % HistorySize;
+		if (History.Times[Older] <= Time)
+		{
+			const float Span = History.Times[Newer] - History.Times[Older];
+			const float Alpha = Span > 0.0f ? (Time - History.Times[Older]) / Span : 1.0f;
+			return FMath::Lerp(History.Locations[Older], History.Locations[Newer], FMath::Clamp(Alpha, 0.0f, 1.0f));
+		}
+		Newer = Older;
+	}
+
+	// Older than the history: the oldest sample is the best guess
+	return History.Locations[Newer];
+}
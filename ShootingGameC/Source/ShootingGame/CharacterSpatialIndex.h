@@ -0,0 +1,214 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CharacterSpatialIndex.generated.h"
+
+class AShootingGameCharacter;
+
+/**
+ * Uniform 2D grid of characters hashed into a fixed bucket table.
+ * Characters relink only when they cross a cell, and queries walk the buckets in place without allocating.
+ */
+UCLASS()
+class SHOOTINGGAME_API UCharacterSpatialIndex : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Returns the handle used for Update and Remove */
+	int32 Add(AShootingGameCharacter* Char, const FVector& Location);
+
+	void Remove(int32 Handle);
+
+	void Update(int32 Handle, const FVector& Location);
+
+	FORCEINLINE int32 Num() const { return NumCharacters; }
+
+	/** Where the character was at a past world time, interpolated from the recorded history */
+	FVector GetLocationAtTime(int32 Handle, float Time) const;
+
+	/** How far back the history reaches at any frame rate; GetLocationAtTime holds the oldest sample beyond it */
+	static float GetHistoryDuration();
+
+	/**
+	 * Like ForEachInRadius, but tests and reports every character where it was at Time.
+	 * Slack widens the search around current positions to cover how far characters moved since then.
+	 */
+	template<typename FuncType>
+	void ForEachInRadiusAtTime(const FVector& Center, float Radius, float Time, float Slack, FuncType&& Func) const
+	{
+		const float RadiusSq = Radius * Radius;
+		ForEachInBounds(Center, Radius + Slack, [&](const FEntry& Entry)
+		{
+			const FVector Location = GetLocationAtTime(&Entry - Entries.GetData(), Time);
+			const float DistSq = FVector::DistSquared(Location, Center);
+			if (DistSq <= RadiusSq)
+			{
+				Func(Entry.Char, Location, DistSq);
+			}
+		});
+	}
+
+	/** Calls Func(Character, Location) for every indexed character, in handle order */
+	template<typename FuncType>
+	void ForEachCharacter(FuncType&& Func) const
+	{
+		for (const FEntry& Entry : Entries)
+		{
+			if (Entry.Char)
+			{
+				Func(Entry.Char, Entry.Location);
+			}
+		}
+	}
+
+	/** Calls Func(Character, Location, DistSquared) for every character within Radius of Center */
+	template<typename FuncType>
+	void ForEachInRadius(const FVector& Center, float Radius, FuncType&& Func) const
+	{
+		const float RadiusSq = Radius * Radius;
+		ForEachInBounds(Center, Radius, [&](const FEntry& Entry)
+		{
+			const float DistSq = FVector::DistSquared(Entry.Location, Center);
+			if (DistSq <= RadiusSq)
+			{
+				Func(Entry.Char, Entry.Location, DistSq);
+			}
+		});
+	}
+
+	/** Calls Func(Character, Location, DistSquared) for every character inside the cone. Direction must be normalized. */
+	template<typename FuncType>
+	void ForEachInCone(const FVector& Origin, const FVector& Direction, float Length, float HalfAngleDegrees, FuncType&& Func) const
+	{
+		const float CosHalfAngle = FMath::Cos(FMath::DegreesToRadians(HalfAngleDegrees));
+		ForEachInRadius(Origin, Length, [&](AShootingGameCharacter* Char, const FVector& Location, float DistSq)
+		{
+			const FVector Delta = Location - Origin;
+			if (DistSq <= KINDA_SMALL_NUMBER || (Delta | Direction) >= CosHalfAngle * FMath::Sqrt(DistSq))
+			{
+				Func(Char, Location, DistSq);
+			}
+		});
+	}
+
+	/** Fills Out with up to K characters nearest to Center within MaxRadius, closest first */
+	template<typename AllocatorType>
+	void FindNearest(const FVector& Center, int32 K, float MaxRadius, TArray<AShootingGameCharacter*, AllocatorType>& Out) const
+	{
+		Out.Reset();
+		if (K <= 0)
+			return;
+
+		TArray<float, TInlineAllocator<16>> Dists;
+		ForEachInRadius(Center, MaxRadius, [&](AShootingGameCharacter* Char, const FVector& Location, float DistSq)
+		{
+			if (Out.Num() == K && DistSq >= Dists.Last())
+				return;
+
+			int32 Insert = Out.Num() == K ? K - 1 : Out.Num();
+			if (Out.Num() == K)
+			{
+				Out.Pop(false);
+				Dists.Pop(false);
+			}
+			while (Insert > 0 && Dists[Insert - 1] > DistSq)
+			{
+				--Insert;
+			}
+			Out.Insert(Char, Insert);
+			Dists.Insert(DistSq, Insert);
+		});
+	}
+
+private:
+	/** Samples are kept at least HistoryInterval apart, so a fast server tick cannot shorten the history */
+	static const int32 HistorySize = 64;
+
+	/** Ring of recent locations, kept apart from FEntry so queries over current positions stay compact */
+	struct FHistory
+	{
+		FVector Locations[HistorySize];
+		float Times[HistorySize];
+		int32 Head;
+		int32 Num;
+	};
+
+	struct FEntry
+	{
+		FVector Location;
+		AShootingGameCharacter* Char;
+		FIntPoint Cell;
+		int32 Prev;
+		int32 Next;
+	};
+
+	FORCEINLINE FIntPoint GetCell(const FVector& Location) const
+	{
+		return FIntPoint(FMath::FloorToInt(Location.X * InvCellSize), FMath::FloorToInt(Location.Y * InvCellSize));
+	}
+
+	FORCEINLINE int32 GetBucket(const FIntPoint& Cell) const
+	{
+		return (int32)(((uint32)Cell.X * 73856093u) ^ ((uint32)Cell.Y * 19349663u)) & (BucketHeads.Num() - 1);
+	}
+
+	void Link(int32 Handle);
+
+	void Unlink(int32 Handle);
+
+	void Record(int32 Handle, const FVector& Location);
+
+	template<typename FuncType>
+	void ForEachInBounds(const FVector& Center, float Radius, FuncType&& Func) const
+	{
+		const FIntPoint Min = GetCell(Center - FVector(Radius));
+		const FIntPoint Max = GetCell(Center + FVector(Radius));
+
+		// Past this many cells a linear pass over the live entries is cheaper than probing the hash
+		if ((int64)(Max.X - Min.X + 1) * (Max.Y - Min.Y + 1) > NumCharacters)
+		{
+			for (const FEntry& Entry : Entries)
+			{
+				if (Entry.Char)
+				{
+					Func(Entry);
+				}
+			}
+			return;
+		}
+
+		for (int32 y = Min.Y; y <= Max.Y; ++y)
+		{
+			for (int32 x = Min.X; x <= Max.X; ++x)
+			{
+				const FIntPoint Cell(x, y);
+				for (int32 i = BucketHeads[GetBucket(Cell)]; i != INDEX_NONE; i = Entries[i].Next)
+				{
+					// Several cells share a bucket, so skip entries that belong to another cell
+					if (Entries[i].Cell == Cell)
+					{
+						Func(Entries[i]);
+					}
+				}
+			}
+		}
+	}
+
+	TArray<FEntry> Entries;
+
+	TArray<FHistory> Histories;
+
+	TArray<int32> FreeEntries;
+
+	TArray<int32> BucketHeads;
+
+	int32 NumCharacters;
+
+	float InvCellSize;
+};
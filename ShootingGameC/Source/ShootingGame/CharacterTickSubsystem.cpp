@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CharacterTickSubsystem.h"
+#include "ShootingGame.h"
+#include "ShootingGameCharacter.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Character Batched Tick"), STAT_CharacterBatchedTick, STATGROUP_ShootingGame);
+DECLARE_CYCLE_STAT(TEXT("Character Batched Tick Sample"), STAT_CharacterBatchedTickSample, STATGROUP_ShootingGame);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Batched Characters"), STAT_BatchedCharacters, STATGROUP_ShootingGame);
+
+static TAutoConsoleVariable<int32> CVarBatchedTickParallel(
+	TEXT("sg.BatchedTickParallel"),
+	1,
+	TEXT("Sample batched character ticks on worker threads.\n")
+	TEXT("0: sample on the game thread, 1: use ParallelFor once there are enough characters"));
+
+static TAutoConsoleVariable<int32> CVarBatchedTickMinParallel(
+	TEXT("sg.BatchedTickMinParallel"),
+	64,
+	TEXT("Fewest characters worth splitting across worker threads"));
+
+int32 UCharacterTickSubsystem::Register(AShootingGameCharacter* Char)
+{
+	INC_DWORD_STAT(STAT_BatchedCharacters);
+
+	return Characters.Add(Char);
+}
+
+void UCharacterTickSubsystem::Unregister(int32 Handle)
+{
+	if (Characters.IsValidIndex(Handle) == false)
+		return;
+
+	DEC_DWORD_STAT(STAT_BatchedCharacters);
+
+	Characters.RemoveAtSwap(Handle, 1, false);
+	if (Characters.IsValidIndex(Handle))
+	{
+		Characters[Handle]->SetBatchedTickHandle(Handle);
+	}
+}
+
+void UCharacterTickSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CharacterBatchedTick);
+
+	const int32 Num = Characters.Num();
+	Samples.SetNumUninitialized(Num, false);
+
+	// Sampling only reads each character's own state, so it can run anywhere
+	{
+		SCOPE_CYCLE_COUNTER(STAT_CharacterBatchedTickSample);
+
+		const float Now = GetWorld()->GetTimeSeconds();
+		const bool bSingleThread = CVarBatchedTickParallel.GetValueOnGameThread() == 0 || Num < CVarBatchedTickMinParallel.GetValueOnGameThread();
+		ParallelFor(Num, [this, Now](int32 i)
+		{
+			Characters[i]->SampleBatchedTick(Samples[i], Now);
+		}, bSingleThread);
+	}
+
+	// Replication flags, dormancy and the spatial index are shared, so commit here in array order
+	for (int32 i = 0; i < Num; ++i)
+	{
+		Characters[i]->CommitBatchedTick(Samples[i]);
+	}
+}
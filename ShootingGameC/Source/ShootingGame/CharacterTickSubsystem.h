@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CharacterTickSubsystem.generated.h"
+
+class AShootingGameCharacter;
+
+/** What a character's batched tick reads, gathered without touching shared state */
+struct FCharacterTickSample
+{
+	FVector Location;
+	bool IsMoving;
+
+	/** The net idle cooldown has run out without activity */
+	bool IsNetIdleDue;
+};
+
+/**
+ * Ticks every active shooter character from one tick function instead of one actor tick each.
+ * Samples are gathered over the contiguous array in parallel, then committed on the game thread in array order.
+ */
+UCLASS()
+class SHOOTINGGAME_API UCharacterTickSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Returns the handle used for Unregister */
+	int32 Register(AShootingGameCharacter* Char);
+
+	void Unregister(int32 Handle);
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return Characters.Num() > 0; }
+	virtual ETickableTickType GetTickableTickType() const override { return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional; }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(UCharacterTickSubsystem, STATGROUP_Tickables); }
+
+private:
+	TArray<AShootingGameCharacter*> Characters;
+
+	// Parallel to Characters and kept between frames so ticking does not allocate
+	TArray<FCharacterTickSample> Samples;
+};
@@ -0,0 +1,143 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CosmeticEventSubsystem.h"
+#include "ShootingGame.h"
+#include "ShootingGameCharacter.h"
+#include "ShootingPlayerState.h"
+#include "GameFramework/PlayerController.h"
+#include "Engine/NetConnection.h"
+
+DECLARE_CYCLE_STAT(TEXT("Cosmetic Events"), STAT_CosmeticEvents, STATGROUP_ShootingGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cosmetic Events Queued"), STAT_CosmeticEventsQueued, STATGROUP_ShootingGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cosmetic Events Sent"), STAT_CosmeticEventsSent, STATGROUP_ShootingGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cosmetic Event Batches"), STAT_CosmeticEventBatches, STATGROUP_ShootingGame);
+
+bool FCosmeticEvent::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	UObject* Obj = Character;
+	Map->SerializeObject(Ar, AShootingGameCharacter::StaticClass(), Obj);
+	Character = Cast<AShootingGameCharacter>(Obj);
+
+	uint8 TypeByte = (uint8)Type;
+	Ar << TypeByte;
+	Type = (ECosmeticEventType)TypeByte;
+
+	// Fire and reload only need the character, the location was for culling on the server
+	if (Type == ECosmeticEventType::HitImpact)
+	{
+		Location.NetSerialize(Ar, Map, bOutSuccess);
+		Normal.NetSerialize(Ar, Map, bOutSuccess);
+	}
+
+	return bOutSuccess;
+}
+
+void FCosmeticEvent::Play() const
+{
+	if (IsValid(Character) == false)
+		return;
+
+	switch (Type)
+	{
+	case ECosmeticEventType::Fire:
+		Character->PlayPressTrigger();
+		break;
+	case ECosmeticEventType::Reload:
+		Character->PlayPressReload();
+		break;
+	case ECosmeticEventType::HitImpact:
+		Character->PlayHitImpact(Location, Normal);
+		break;
+	}
+}
+
+UCosmeticEventSubsystem::UCosmeticEventSubsystem()
+{
+	CullDistance = 10000.0f;
+	MaxEventsPerBatch = 32;
+}
+
+void UCosmeticEventSubsystem::QueueEvent(ECosmeticEventType Type, AShootingGameCharacter* Character, const FVector& Location, const FVector& Normal)
+{
+	const ENetMode NetMode = GetWorld()->GetNetMode();
+	if (NetMode == NM_Client)
+		return;
+
+	FCosmeticEvent Event;
+	Event.Character = Character;
+	Event.Type = Type;
+	Event.Location = Location;
+	Event.Normal = Normal;
+
+	// A local player (standalone or listen server host) plays fire and reload with the server's own copy, impacts have no other path
+	if (NetMode != NM_DedicatedServer && Type == ECosmeticEventType::HitImpact)
+	{
+		Event.Play();
+	}
+
+	// Standalone has nobody to send to
+	if (NetMode == NM_Standalone)
+		return;
+
+	INC_DWORD_STAT(STAT_CosmeticEventsQueued);
+
+	PendingEvents.Add(Event);
+}
+
+void UCosmeticEventSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CosmeticEvents);
+
+	const float CullDistanceSq = FMath::Square(CullDistance);
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* pc = It->Get();
+		if (pc == nullptr || pc->IsLocalController())
+			continue;
+
+		UNetConnection* Connection = pc->GetNetConnection();
+		AShootingPlayerState* ps = pc->GetPlayerState<AShootingPlayerState>();
+		if (Connection == nullptr || ps == nullptr)
+			continue;
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		pc->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+		Batch.Reset();
+		for (const FCosmeticEvent& Event : PendingEvents)
+		{
+			if (IsValid(Event.Character) == false)
+				continue;
+
+			// The owner already got its own fire and reload reliably
+			if (Event.Type != ECosmeticEventType::HitImpact && Event.Character == pc->GetPawn())
+				continue;
+
+			if (FVector::DistSquared(Event.Location, ViewLocation) > CullDistanceSq)
+				continue;
+
+			// Without a channel the character is not relevant to this client, which could not resolve it anyway
+			if (Connection->FindActorChannelRef(Event.Character) == nullptr)
+				continue;
+
+			Batch.Add(Event);
+			if (Batch.Num() == MaxEventsPerBatch)
+				break;
+		}
+
+		if (Batch.Num() > 0)
+		{
+			INC_DWORD_STAT_BY(STAT_CosmeticEventsSent, Batch.Num());
+			INC_DWORD_STAT(STAT_CosmeticEventBatches);
+
+			ps->ResCosmeticEvents(Batch);
+		}
+	}
+
+	PendingEvents.Reset();
+}
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CosmeticEventSubsystem.generated.h"
+
+class AShootingGameCharacter;
+
+UENUM()
+enum class ECosmeticEventType : uint8
+{
+	Fire,
+	Reload,
+	HitImpact,
+};
+
+/** One cosmetic event in a batch. Only hit impacts carry their location and normal over the wire. */
+USTRUCT()
+struct FCosmeticEvent
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	AShootingGameCharacter* Character = nullptr;
+
+	UPROPERTY()
+	ECosmeticEventType Type = ECosmeticEventType::Fire;
+
+	UPROPERTY()
+	FVector_NetQuantize Location;
+
+	UPROPERTY()
+	FVector_NetQuantizeNormal Normal;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	/** Plays the event on this machine */
+	void Play() const;
+};
+
+template<>
+struct TStructOpsTypeTraits<FCosmeticEvent> : public TStructOpsTypeTraitsBase2<FCosmeticEvent>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/**
+ * Server: collects the frame's cosmetic events and sends each remote connection one unreliable batch,
+ * holding only events near its view and for characters it already has a channel for.
+ * A lost batch only costs a few animations or effects.
+ */
+UCLASS()
+class SHOOTINGGAME_API UCosmeticEventSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UCosmeticEventSubsystem();
+
+	void QueueEvent(ECosmeticEventType Type, AShootingGameCharacter* Character, const FVector& Location, const FVector& Normal = FVector::UpVector);
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return PendingEvents.Num() > 0; }
+	virtual ETickableTickType GetTickableTickType() const override { return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional; }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(UCosmeticEventSubsystem, STATGROUP_Tickables); }
+
+	/** Events farther than this from a connection's view are not sent to it */
+	float CullDistance;
+
+	/** Upper bound on one connection's batch per frame, events past it are dropped for that connection */
+	int32 MaxEventsPerBatch;
+
+private:
+	TArray<FCosmeticEvent> PendingEvents;
+
+	// Reused for every connection's batch
+	TArray<FCosmeticEvent> Batch;
+};
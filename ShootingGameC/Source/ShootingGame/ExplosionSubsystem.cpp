@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ExplosionSubsystem.h"
+#include "ShootingGame.h"
+#include "ShootingGameCharacter.h"
+#include "ShootingPlayerState.h"
+#include "CharacterSpatialIndex.h"
+#include "Kismet/GameplayStatics.h"
+
+DECLARE_CYCLE_STAT(TEXT("Explosions"), STAT_Explosions, STATGROUP_ShootingGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Explosion Occlusion Traces"), STAT_ExplosionTraces, STATGROUP_ShootingGame);
+
+void UExplosionSubsystem::QueueExplosion(const FVector& Origin, float Radius, float BaseDamage, float MinDamage, float Falloff, AController* EventInstigator, AActor* DamageCauser)
+{
+	if (GetWorld()->GetNetMode() == NM_Client || Radius <= 0.0f)
+		return;
+
+	FPendingExplosion& Explosion = PendingExplosions.AddDefaulted_GetRef();
+	Explosion.Origin = Origin;
+	Explosion.Radius = Radius;
+	Explosion.BaseDamage = BaseDamage;
+	Explosion.MinDamage = MinDamage;
+	Explosion.Falloff = Falloff;
+	Explosion.EventInstigator = EventInstigator;
+	Explosion.DamageCauser = DamageCauser;
+	Explosion.DamageMask = AShootingPlayerState::GetDamageMask(EventInstigator);
+}
+
+void UExplosionSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_Explosions);
+
+	UWorld* World = GetWorld();
+	UCharacterSpatialIndex* Index = World->GetSubsystem<UCharacterSpatialIndex>();
+
+	// Gather every (explosion, victim) pair and its falloff damage in one pass
+	Hits.Reset();
+	for (int32 i = 0; i < PendingExplosions.Num(); ++i)
+	{
+		const FPendingExplosion& Explosion = PendingExplosions[i];
+		const float InvRadius = 1.0f / Explosion.Radius;
+
+		const AController* EventInstigator = Explosion.EventInstigator.Get();
+
+		Index->ForEachInRadius(Explosion.Origin, Explosion.Radius, [&](AShootingGameCharacter* Char, const FVector& Location, float DistSq)
+		{
+			// Friendly victims are dropped before they cost an occlusion trace
+			if (Char->CanBeDamagedBy(EventInstigator, Explosion.DamageMask) == false)
+				return;
+
+			const float Alpha = FMath::Pow(FMath::Sqrt(DistSq) * InvRadius, Explosion.Falloff);
+			Hits.Add({ Char, Location, i, FMath::Lerp(Explosion.BaseDamage, Explosion.MinDamage, Alpha) });
+		});
+	}
+
+	// Occlusion checks back to back, then sum per victim
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ExplosionOcclusion));
+	VictimDamage.Reset();
+	for (const FExplosionHit& Hit : Hits)
+	{
+		const FPendingExplosion& Explosion = PendingExplosions[Hit.Explosion];
+
+		QueryParams.ClearIgnoredActors();
+		QueryParams.AddIgnoredActor(Hit.Victim);
+		QueryParams.AddIgnoredActor(Explosion.DamageCauser.Get());
+
+		INC_DWORD_STAT(STAT_ExplosionTraces);
+		if (World->LineTraceTestByChannel(Explosion.Origin, Hit.VictimLocation, ECC_Visibility, QueryParams))
+			continue;
+
+		FVictimDamage& Total = VictimDamage.FindOrAdd(Hit.Victim, { 0.0f, Hit.Explosion });
+		Total.Damage += Hit.Damage;
+	}
+
+	// One health update per victim, credited to the first explosion that reached it
+	for (const TPair<AShootingGameCharacter*, FVictimDamage>& Pair : VictimDamage)
+	{
+		if (IsValid(Pair.Key) == false)
+			continue;
+
+		const FPendingExplosion& Explosion = PendingExplosions[Pair.Value.Explosion];
+		UGameplayStatics::ApplyDamage(Pair.Key, Pair.Value.Damage, Explosion.EventInstigator.Get(), Explosion.DamageCauser.Get(), UDamageType::StaticClass());
+	}
+
+	PendingExplosions.Reset();
+}
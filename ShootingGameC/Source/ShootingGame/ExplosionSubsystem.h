@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ExplosionSubsystem.generated.h"
+
+class AShootingGameCharacter;
+
+/**
+ * Collects the explosions of a frame and resolves them together on the server: victims come from the
+ * character spatial index, occlusion traces run in one loop and each victim gets a single summed ApplyDamage.
+ */
+UCLASS()
+class SHOOTINGGAME_API UExplosionSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Damage is BaseDamage at the origin and falls to MinDamage at Radius, shaped by Falloff as an exponent */
+	void QueueExplosion(const FVector& Origin, float Radius, float BaseDamage, float MinDamage, float Falloff, AController* EventInstigator, AActor* DamageCauser);
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return PendingExplosions.Num() > 0; }
+	virtual ETickableTickType GetTickableTickType() const override { return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional; }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(UExplosionSubsystem, STATGROUP_Tickables); }
+
+private:
+	struct FPendingExplosion
+	{
+		FVector Origin;
+		float Radius;
+		float BaseDamage;
+		float MinDamage;
+		float Falloff;
+		TWeakObjectPtr<AController> EventInstigator;
+		TWeakObjectPtr<AActor> DamageCauser;
+		/** Teams the instigator may damage, taken when queued so a dead instigator keeps its team */
+		uint32 DamageMask;
+	};
+
+	struct FExplosionHit
+	{
+		AShootingGameCharacter* Victim;
+		FVector VictimLocation;
+		int32 Explosion;
+		float Damage;
+	};
+
+	struct FVictimDamage
+	{
+		float Damage;
+		int32 Explosion;
+	};
+
+	TArray<FPendingExplosion> PendingExplosions;
+
+	// Kept between frames so resolving explosions does not allocate once warmed up
+	TArray<FExplosionHit> Hits;
+
+	TMap<AShootingGameCharacter*, FVictimDamage> VictimDamage;
+};
@@ -0,0 +1,203 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NetClockSyncComponent.h"
+#include "ShootingGame.h"
+#include "ShootingPlayerState.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/App.h"
+
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Clock Sync RTT (ms)"), STAT_ClockSyncRtt, STATGROUP_ShootingGame);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Clock Sync Jitter (ms)"), STAT_ClockSyncJitter, STATGROUP_ShootingGame);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Clock Sync Slew (ms)"), STAT_ClockSyncSlew, STATGROUP_ShootingGame);
+
+FClockSyncEstimator::FClockSyncEstimator()
+{
+	NextSample = 0;
+	NumSamples = 0;
+	TotalSamples = 0;
+	TargetOffset = 0.0;
+	CurrentOffset = 0.0;
+	SeedOffset = 0.0;
+	HasSeed = false;
+	BestRoundTripTime = 0.0f;
+	LastRoundTripTime = 0.0f;
+	Jitter = 0.0f;
+}
+
+void FClockSyncEstimator::Seed(double Offset)
+{
+	SeedOffset = Offset;
+	HasSeed = true;
+}
+
+void FClockSyncEstimator::AddSample(double ClientTime, double ServerTime, float HoldTime, double ReceiveTime)
+{
+	const double RoundTripTime = FMath::Max(0.0, ReceiveTime - ClientTime - HoldTime);
+
+	// Four timestamps as in NTP, with the send stamp being ServerTime + HoldTime
+	FClockSample& Sample = Samples[NextSample];
+	Sample.RoundTripTime = RoundTripTime;
+	Sample.Offset = ((ServerTime - ClientTime) + (ServerTime + HoldTime - ReceiveTime)) * 0.5;
+	NextSample = (NextSample + 1) % WindowSize;
+	NumSamples = FMath::Min(NumSamples + 1, WindowSize);
+
+	if (TotalSamples > 0)
+	{
+		Jitter += (FMath::Abs((float)RoundTripTime - LastRoundTripTime) - Jitter) / 16.0f;
+	}
+	LastRoundTripTime = RoundTripTime;
+
+	// The fastest round trip had the least queueing, so its midpoint assumption is the most trustworthy
+	int32 Best = 0;
+	for (int32 i = 1; i < NumSamples; ++i)
+	{
+		if (Samples[i].RoundTripTime < Samples[Best].RoundTripTime)
+		{
+			Best = i;
+		}
+	}
+	TargetOffset = Samples[Best].Offset;
+	BestRoundTripTime = Samples[Best].RoundTripTime;
+
+	// Start from the seed rather than stepping to the first sample; Slew then closes the gap without running backward
+	if (TotalSamples == 0)
+	{
+		CurrentOffset = HasSeed ? SeedOffset : TargetOffset;
+	}
+	++TotalSamples;
+}
+
+void FClockSyncEstimator::Slew(float DeltaTime, float MaxSlewRate)
+{
+	if (IsSynced() == false)
+		return;
+
+	// Forward corrections are taken at once; backward ones are spread out so the estimate keeps moving forward
+	const double Delta = TargetOffset - CurrentOffset;
+	CurrentOffset += (Delta > 0.0) ? Delta : FMath::Max(Delta, -(double)(MaxSlewRate * DeltaTime));
+}
+
+UNetClockSyncComponent::UNetClockSyncComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	SetIsReplicatedByDefault(true);
+
+	SyncInterval = 1.0f;
+	FastSyncInterval = 0.1f;
+	FastSyncCount = 10;
+	MaxSlewRate = 0.05f;
+
+	NextSyncTime = 0.0;
+	ReportedRoundTripTime = 0.0f;
+	ReportedJitter = 0.0f;
+	ReportedInterpolationDelay = 0.0f;
+	PendingInterpolationDelay = 0.0f;
+}
+
+void UNetClockSyncComponent::StartSync()
+{
+	if (GetOwnerRole() == ROLE_Authority || IsComponentTickEnabled())
+		return;
+
+	NextSyncTime = 0.0;
+	SetComponentTickEnabled(true);
+}
+
+void UNetClockSyncComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const double Now = FPlatformTime::Seconds();
+	if (Now >= NextSyncTime)
+	{
+		NextSyncTime = Now + (Estimator.GetTotalSamples() < FastSyncCount ? FastSyncInterval : SyncInterval);
+		ReqClockSync(Now, Estimator.GetLastRoundTripTime(), Estimator.GetJitter(), PendingInterpolationDelay);
+		PendingInterpolationDelay = 0.0f;
+	}
+
+	if (IsSynced() == false)
+		return;
+
+	Estimator.Slew(DeltaTime, MaxSlewRate);
+
+	SET_FLOAT_STAT(STAT_ClockSyncSlew, (Estimator.GetTargetOffset() - Estimator.GetCurrentOffset()) * 1000.0);
+}
+
+double UNetClockSyncComponent::GetServerNow() const
+{
+	// World time only advances once per frame, so add how far into the frame we are
+	return GetWorld()->GetTimeSeconds() + (FPlatformTime::Seconds() - FApp::GetCurrentTime());
+}
+
+double UNetClockSyncComponent::GetEstimatedServerTime() const
+{
+	if (GetOwnerRole() == ROLE_Authority)
+		return GetServerNow();
+
+	return FPlatformTime::Seconds() + Estimator.GetCurrentOffset();
+}
+
+void UNetClockSyncComponent::NoteInterpolationDelay(float Delay)
+{
+	PendingInterpolationDelay = FMath::Max(PendingInterpolationDelay, Delay);
+}
+
+void UNetClockSyncComponent::ReqClockSync_Implementation(double ClientTime, float RoundTripTime, float ClientJitter, float InterpolationDelay)
+{
+	const double ServerTime = GetServerNow();
+
+	// The reply leaves with the rest of this frame's traffic, so estimate how long it waits
+	const float HoldTime = FMath::Max(0.0, FApp::GetCurrentTime() + FApp::GetDeltaTime() - FPlatformTime::Seconds());
+
+	ReportedRoundTripTime = FMath::Clamp(RoundTripTime, 0.0f, 10.0f);
+	ReportedJitter = FMath::Clamp(ClientJitter, 0.0f, 10.0f);
+	// Bounded like the rewind itself, so a client cannot claim an arbitrary view delay
+	ReportedInterpolationDelay = FMath::Clamp(InterpolationDelay, 0.0f, 0.5f);
+
+	ResClockSync(ClientTime, ServerTime, HoldTime);
+}
+
+void UNetClockSyncComponent::ResClockSync_Implementation(double ClientTime, double ServerTime, float HoldTime)
+{
+	const double ReceiveTime = FPlatformTime::Seconds();
+
+	// Until now GetServerTime showed the game state's estimate; continue from it so server time never steps backward
+	if (IsSynced() == false)
+	{
+		Estimator.Seed(GetFallbackServerTime(GetWorld()) - ReceiveTime);
+	}
+
+	Estimator.AddSample(ClientTime, ServerTime, HoldTime, ReceiveTime);
+
+	SET_FLOAT_STAT(STAT_ClockSyncRtt, Estimator.GetBestRoundTripTime() * 1000.0f);
+	SET_FLOAT_STAT(STAT_ClockSyncJitter, Estimator.GetJitter() * 1000.0f);
+}
+
+UNetClockSyncComponent* UNetClockSyncComponent::GetLocal(const UWorld* World)
+{
+	APlayerController* pc = World->GetFirstPlayerController();
+	AShootingPlayerState* ps = pc ? pc->GetPlayerState<AShootingPlayerState>() : nullptr;
+	return ps ? ps->GetClockSync() : nullptr;
+}
+
+double UNetClockSyncComponent::GetServerTime(const UWorld* World)
+{
+	if (World->GetNetMode() != NM_Client)
+		return World->GetTimeSeconds();
+
+	UNetClockSyncComponent* Clock = GetLocal(World);
+	if (Clock && Clock->IsSynced())
+		return Clock->GetEstimatedServerTime();
+
+	return GetFallbackServerTime(World);
+}
+
+double UNetClockSyncComponent::GetFallbackServerTime(const UWorld* World)
+{
+	AGameStateBase* GameState = World->GetGameState();
+	return GameState ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+}
@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "NetClockSyncComponent.generated.h"
+
+/**
+ * The sample window and offset math behind UNetClockSyncComponent, kept free of the engine so it can be tested on its own.
+ * All times are in seconds; offsets are server time minus local time.
+ */
+struct FClockSyncEstimator
+{
+	FClockSyncEstimator();
+
+	/** Offset to start from at the first sample, so the estimate continues from whatever server time was shown before */
+	void Seed(double Offset);
+
+	/** One request/response: sent at ClientTime, arrived at ServerTime, held HoldTime on the server, received at ReceiveTime */
+	void AddSample(double ClientTime, double ServerTime, float HoldTime, double ReceiveTime);
+
+	/** Moves CurrentOffset toward TargetOffset: forward at once, backward no faster than MaxSlewRate */
+	void Slew(float DeltaTime, float MaxSlewRate);
+
+	FORCEINLINE bool IsSynced() const { return NumSamples > 0; }
+
+	FORCEINLINE int32 GetTotalSamples() const { return TotalSamples; }
+
+	FORCEINLINE double GetCurrentOffset() const { return CurrentOffset; }
+
+	FORCEINLINE double GetTargetOffset() const { return TargetOffset; }
+
+	FORCEINLINE float GetBestRoundTripTime() const { return BestRoundTripTime; }
+
+	FORCEINLINE float GetLastRoundTripTime() const { return LastRoundTripTime; }
+
+	FORCEINLINE float GetJitter() const { return Jitter; }
+
+private:
+	static const int32 WindowSize = 16;
+
+	struct FClockSample
+	{
+		double RoundTripTime;
+		double Offset;
+	};
+
+	FClockSample Samples[WindowSize];
+
+	int32 NextSample;
+
+	int32 NumSamples;
+
+	int32 TotalSamples;
+
+	/** Offset of the best sample in the window */
+	double TargetOffset;
+
+	/** Offset in use, slewed toward TargetOffset */
+	double CurrentOffset;
+
+	double SeedOffset;
+
+	bool HasSeed;
+
+	float BestRoundTripTime;
+
+	float LastRoundTripTime;
+
+	float Jitter;
+};
+
+/**
+ * NTP-style clock sync between an owning client and the server, kept on the player state.
+ * The client times request/response round trips, takes the offset from the lowest-RTT sample of a sliding window
+ * and slews toward it, so its estimated server time never runs backward. RTT and jitter are reported back to the server.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class SHOOTINGGAME_API UNetClockSyncComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UNetClockSyncComponent();
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Owning client: starts sampling. Does nothing on the server. */
+	void StartSync();
+
+	/** Server world time, estimated on clients and exact on the server, with sub-frame resolution */
+	double GetEstimatedServerTime() const;
+
+	FORCEINLINE bool IsSynced() const { return Estimator.IsSynced(); }
+
+	/** Lowest round trip in the sample window, in seconds */
+	FORCEINLINE float GetRoundTripTime() const { return Estimator.GetBestRoundTripTime(); }
+
+	/** Smoothed round trip variation, in seconds */
+	FORCEINLINE float GetJitter() const { return Estimator.GetJitter(); }
+
+	/** Server: what the owning client last measured */
+	FORCEINLINE float GetReportedRoundTripTime() const { return ReportedRoundTripTime; }
+
+	FORCEINLINE float GetReportedJitter() const { return ReportedJitter; }
+
+	/** Server: how far behind server time the owning client renders other characters */
+	FORCEINLINE float GetReportedInterpolationDelay() const { return ReportedInterpolationDelay; }
+
+	/** Owning client: records the snapshot interpolation delay in use; the largest since the last request is reported */
+	void NoteInterpolationDelay(float Delay);
+
+	/** Clock sync of the first local player, if it has a player state yet */
+	static UNetClockSyncComponent* GetLocal(const UWorld* World);
+
+	/** Server world time from the local player's clock sync, or the game state's estimate until it has a sample */
+	static double GetServerTime(const UWorld* World);
+
+	/** What GetServerTime shows before the first sample */
+	static double GetFallbackServerTime(const UWorld* World);
+
+	UFUNCTION(Server, Unreliable)
+	void ReqClockSync(double ClientTime, float RoundTripTime, float ClientJitter, float InterpolationDelay);
+
+	/** ServerTime is when the request arrived, HoldTime how long the server will likely hold the reply before sending */
+	UFUNCTION(Client, Unreliable)
+	void ResClockSync(double ClientTime, double ServerTime, float HoldTime);
+
+public:
+	/** Seconds between requests once the first FastSyncCount samples are in */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Clock Sync")
+	float SyncInterval;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Clock Sync")
+	float FastSyncInterval;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Clock Sync")
+	int32 FastSyncCount;
+
+	/** Fastest the estimate is pulled back toward a lower offset, in seconds per second. Must stay below 1 to keep time monotonic. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Clock Sync")
+	float MaxSlewRate;
+
+private:
+	/** Server clock at this instant rather than at the start of the frame */
+	double GetServerNow() const;
+
+	FClockSyncEstimator Estimator;
+
+	double NextSyncTime;
+
+	float ReportedRoundTripTime;
+
+	float ReportedJitter;
+
+	float ReportedInterpolationDelay;
+
+	float PendingInterpolationDelay;
+};
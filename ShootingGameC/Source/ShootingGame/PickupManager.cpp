@@ -0,0 +1,221 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PickupManager.h"
+#include "ShootingGame.h"
+#include "ShootingGameCharacter.h"
+#include "ShootingPlayerState.h"
+#include "Weapon.h"
+#include "WeaponInventoryComponent.h"
+#include "CharacterSpatialIndex.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Net/UnrealNetwork.h"
+
+DECLARE_CYCLE_STAT(TEXT("Pickup Tick"), STAT_PickupTick, STATGROUP_ShootingGame);
+
+void FPickupItem::PostReplicatedAdd(const FPickupArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->UpdateInstance(*this);
+	}
+}
+
+void FPickupItem::PostReplicatedChange(const FPickupArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->UpdateInstance(*this);
+	}
+}
+
+APickupManager::APickupManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	AmmoMeshes = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("AmmoMeshes"));
+	AmmoMeshes->SetupAttachment(RootComponent);
+	AmmoMeshes->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	WeaponMeshes = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("WeaponMeshes"));
+	WeaponMeshes->SetupAttachment(RootComponent);
+	WeaponMeshes->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	bReplicates = true;
+	bAlwaysRelevant = true;
+	NetUpdateFrequency = 10.0f;
+
+	PickupRadius = 100.0f;
+	RespawnDelay = 30.0f;
+	CellSize = 200.0f;
+}
+
+void APickupManager::GetLifetimeReplicatedProps(TArray< FLifetimeProperty >& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(APickupManager, Pickups);
+}
+
+void APickupManager::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	Pickups.Owner = this;
+}
+
+void APickupManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (HasAuthority() == false)
+	{
+		// Clients only draw what replicates; collection is decided by the server
+		SetActorTickEnabled(false);
+		return;
+	}
+
+	const FTransform& ActorTransform = GetActorTransform();
+	for (const FPickupSpawnPoint& Point : SpawnPoints)
+	{
+		FPickupItem& Item = Pickups.Items.AddDefaulted_GetRef();
+		Item.Location = ActorTransform.TransformPosition(Point.Location);
+		Item.Type = Point.Type;
+		Item.DefinitionId = Point.DefinitionId;
+		Item.Amount = Point.Amount;
+		Pickups.MarkItemDirty(Item);
+
+		if (GetNetMode() != NM_DedicatedServer)
+		{
+			UpdateInstance(Item);
+		}
+	}
+
+	BuildSpatialHash();
+}
+
+void APickupManager::BuildSpatialHash()
+{
+	// A cell at least as wide as the pickup diameter means a character only has to look at its own cell and the 8 around it
+	CellSize = FMath::Max(PickupRadius * 2.0f, 1.0f);
+
+	TArray<TPair<FIntPoint, int32>> Sorted;
+	Sorted.Reserve(Pickups.Items.Num());
+	for (int32 i = 0; i < Pickups.Items.Num(); ++i)
+	{
+		Sorted.Emplace(GetCell(Pickups.Items[i].Location), i);
+	}
+
+	Sorted.Sort([](const TPair<FIntPoint, int32>& A, const TPair<FIntPoint, int32>& B)
+	{
+		return A.Key.X != B.Key.X ? A.Key.X < B.Key.X : A.Key.Y < B.Key.Y;
+	});
+
+	CellRanges.Reset();
+	CellItems.Reset(Sorted.Num());
+	for (int32 i = 0; i < Sorted.Num(); ++i)
+	{
+		FIntPoint& Range = CellRanges.FindOrAdd(Sorted[i].Key, FIntPoint(i, 0));
+		Range.Y++;
+		CellItems.Add(Sorted[i].Value);
+	}
+}
+
+void APickupManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SCOPE_CYCLE_COUNTER(STAT_PickupTick);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	for (int32 i = PendingRespawns.Num() - 1; i >= 0; --i)
+	{
+		FPickupItem& Item = Pickups.Items[PendingRespawns[i]];
+		if (Item.RespawnTime <= Now)
+		{
+			Item.bActive = true;
+			Pickups.MarkItemDirty(Item);
+			UpdateInstance(Item);
+			PendingRespawns.RemoveAtSwap(i, 1, false);
+		}
+	}
+
+	// The spatial index already holds every active character and its location in one compact array
+	GetWorld()->GetSubsystem<UCharacterSpatialIndex>()->ForEachCharacter([this](AShootingGameCharacter* Char, const FVector& Location)
+	{
+		CollectNear(Char, Location);
+	});
+}
+
+void APickupManager::CollectNear(AShootingGameCharacter* Char, const FVector& CharLocation)
+{
+	if (Char->IsHidden())
+		return;
+
+	const FIntPoint Center = GetCell(CharLocation);
+	const float RadiusSq = FMath::Square(PickupRadius);
+
+	for (int32 y = -1; y <= 1; ++y)
+	{
+		for (int32 x = -1; x <= 1; ++x)
+		{
+			const FIntPoint* Range = CellRanges.Find(FIntPoint(Center.X + x, Center.Y + y));
+			if (Range == nullptr)
+				continue;
+
+			for (int32 i = Range->X; i < Range->X + Range->Y; ++i)
+			{
+				FPickupItem& Item = Pickups.Items[CellItems[i]];
+				if (Item.bActive && FVector::DistSquared(Item.Location, CharLocation) <= RadiusSq && TryCollect(Item, Char))
+				{
+					Item.bActive = false;
+					Item.RespawnTime = GetWorld()->GetTimeSeconds() + RespawnDelay;
+					Pickups.MarkItemDirty(Item);
+					UpdateInstance(Item);
+					PendingRespawns.Add(CellItems[i]);
+				}
+			}
+		}
+	}
+}
+
+bool APickupManager::TryCollect(FPickupItem& Item, AShootingGameCharacter* Char)
+{
+	AShootingPlayerState* ps = Cast<AShootingPlayerState>(Char->GetPlayerState());
+	if (ps == nullptr || ps->GetCurHp() <= 0)
+		return false;
+
+	if (Item.Type == EPickupType::Weapon)
+	{
+		return Char->GetInventory()->AddWeapon(Item.DefinitionId, Item.Amount);
+	}
+
+	AWeapon* weapon = Cast<AWeapon>(Char->GetEquipWeapon());
+	if (weapon == nullptr)
+		return false;
+
+	weapon->AddAmmo(Item.Amount);
+	return true;
+}
+
+void APickupManager::UpdateInstance(FPickupItem& Item)
+{
+	if (GetNetMode() == NM_DedicatedServer)
+		return;
+
+	UInstancedStaticMeshComponent* Meshes = (Item.Type == EPickupType::Weapon) ? WeaponMeshes : AmmoMeshes;
+
+	// Collected pickups keep their instance and are scaled to zero, so instance indices never shift
+	const FTransform InstanceTransform(FQuat::Identity, Item.Location, Item.bActive ? FVector::OneVector : FVector::ZeroVector);
+
+	if (Item.InstanceIndex == INDEX_NONE)
+	{
+		Item.InstanceIndex = Meshes->AddInstanceWorldSpace(InstanceTransform);
+	}
+	else
+	{
+		Meshes->UpdateInstanceTransform(Item.InstanceIndex, InstanceTransform, true, true);
+	}
+}
@@ -0,0 +1,161 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Engine/NetSerialization.h"
+#include "PickupManager.generated.h"
+
+class APickupManager;
+class AShootingGameCharacter;
+class UInstancedStaticMeshComponent;
+
+UENUM(BlueprintType)
+enum class EPickupType : uint8
+{
+	Ammo,
+	Weapon,
+};
+
+/** Level-designer placement of a pickup, edited on the manager actor */
+USTRUCT(BlueprintType)
+struct FPickupSpawnPoint
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Meta = (MakeEditWidget = "true"))
+	FVector Location = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere)
+	EPickupType Type = EPickupType::Ammo;
+
+	/** Inventory definition id for weapon pickups */
+	UPROPERTY(EditAnywhere)
+	uint8 DefinitionId = 0;
+
+	UPROPERTY(EditAnywhere)
+	uint8 Amount = 30;
+};
+
+USTRUCT()
+struct FPickupItem : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector_NetQuantize Location;
+
+	UPROPERTY()
+	EPickupType Type = EPickupType::Ammo;
+
+	UPROPERTY()
+	uint8 DefinitionId = 0;
+
+	UPROPERTY()
+	uint8 Amount = 0;
+
+	UPROPERTY()
+	bool bActive = true;
+
+	/** Instance in the mesh component for Type, assigned locally on each machine */
+	UPROPERTY(NotReplicated)
+	int32 InstanceIndex = INDEX_NONE;
+
+	UPROPERTY(NotReplicated)
+	float RespawnTime = 0.0f;
+
+	void PostReplicatedAdd(const struct FPickupArray& InArraySerializer);
+	void PostReplicatedChange(const struct FPickupArray& InArraySerializer);
+};
+
+USTRUCT()
+struct FPickupArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FPickupItem> Items;
+
+	UPROPERTY(NotReplicated)
+	APickupManager* Owner = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FPickupItem, FPickupArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FPickupArray> : public TStructOpsTypeTraitsBase2<FPickupArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/**
+ * Owns every pickup of the level as plain structs. Pickups are drawn with one instanced mesh per type
+ * and collected by testing characters against a static spatial hash, so they cost no actors or collision components.
+ */
+UCLASS()
+class SHOOTINGGAME_API APickupManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	APickupManager();
+
+protected:
+	virtual void BeginPlay() override;
+
+public:
+	virtual void Tick(float DeltaTime) override;
+
+	virtual void PostInitializeComponents() override;
+
+	/** Adds or refreshes the mesh instance drawn for a pickup */
+	void UpdateInstance(FPickupItem& Item);
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UInstancedStaticMeshComponent* AmmoMeshes;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UInstancedStaticMeshComponent* WeaponMeshes;
+
+	UPROPERTY(EditAnywhere, Category = Pickup)
+	TArray<FPickupSpawnPoint> SpawnPoints;
+
+	UPROPERTY(EditAnywhere, Category = Pickup)
+	float PickupRadius;
+
+	UPROPERTY(EditAnywhere, Category = Pickup)
+	float RespawnDelay;
+
+private:
+	void BuildSpatialHash();
+
+	bool TryCollect(FPickupItem& Item, AShootingGameCharacter* Char);
+
+	void CollectNear(AShootingGameCharacter* Char, const FVector& CharLocation);
+
+	FORCEINLINE FIntPoint GetCell(const FVector& Location) const
+	{
+		return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+	}
+
+	UPROPERTY(Replicated)
+	FPickupArray Pickups;
+
+	/** Start and count into CellItems for every occupied cell. Pickups never move, so this is built once. */
+	TMap<FIntPoint, FIntPoint> CellRanges;
+
+	TArray<int32> CellItems;
+
+	/** Indices of collected pickups waiting to respawn */
+	TArray<int32> PendingRespawns;
+
+	float CellSize;
+};
@@ -0,0 +1,231 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProjectileSubsystem.h"
+#include "ShootingGame.h"
+#include "ShootingGameCharacter.h"
+#include "CharacterSpatialIndex.h"
+#include "ExplosionSubsystem.h"
+#include "Weapon.h"
+#include "Components/CapsuleComponent.h"
+#include "NetClockSyncComponent.h"
+#include "ShootingPlayerState.h"
+#include "Kismet/GameplayStatics.h"
+
+DECLARE_CYCLE_STAT(TEXT("Projectile Simulation"), STAT_ProjectileSimulation, STATGROUP_ShootingGame);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Projectiles"), STAT_Projectiles, STATGROUP_ShootingGame);
+
+static const float ProjectileFixedStep = 1.0f / 60.0f;
+static const int32 ProjectileMaxStepsPerFrame = 8;
+
+/** Catch-up beyond this is clamped, so a client cannot claim a shot from arbitrarily far in the past */
+static const float ProjectileMaxRewind = 0.25f;
+
+/** How far a character may have moved during ProjectileMaxRewind, used to widen rewound queries */
+static const float ProjectileRewindSlack = 300.0f;
+
+void UProjectileSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Accumulator = 0.0f;
+}
+
+double UProjectileSubsystem::GetServerTime() const
+{
+	return UNetClockSyncComponent::GetServerTime(GetWorld());
+}
+
+void UProjectileSubsystem::SpawnProjectile(AWeapon* Weapon, const FVector& Origin, const FVector& Direction, int32 Seed, float ServerTime)
+{
+	// The seed makes the spread identical on every machine without replicating the final direction
+	FRandomStream Stream(Seed);
+	const FVector SpreadDirection = Stream.VRandCone(Direction, FMath::DegreesToRadians(Weapon->ProjectileSpread));
+
+	Positions.Add(Origin);
+	Velocities.Add(SpreadDirection * Weapon->ProjectileSpeed);
+	Ages.Add(0.0f);
+	Weapons.Add(Weapon);
+	INC_DWORD_STAT(STAT_Projectiles);
+
+	const int32 Index = Positions.Num() - 1;
+	const bool bAuthority = GetWorld()->GetNetMode() != NM_Client;
+	// A client stamp in the future or further back than we rewind is clamped before anything is derived from it
+	const double Now = GetServerTime();
+	const double ClampedTime = FMath::Clamp((double)ServerTime, Now - ProjectileMaxRewind, Now);
+	float RewindTime = (float)ClampedTime;
+	float CatchUp = (float)(Now - ClampedTime);
+
+	// The shooter saw everyone else where they were InterpolationDelay ago, so check hits against that
+	float ViewDelay = 0.0f;
+	if (bAuthority && Weapon->OwnChar)
+	{
+		AShootingPlayerState* ps = Weapon->OwnChar->GetPlayerState<AShootingPlayerState>();
+		if (ps)
+		{
+			ViewDelay = ps->GetClockSync()->GetReportedInterpolationDelay();
+
+			// Never rewind further than the character history reaches, or every hit test would use the oldest sample
+			ViewDelay = FMath::Min(ViewDelay, FMath::Max(UCharacterSpatialIndex::GetHistoryDuration() - CatchUp, 0.0f));
+		}
+	}
+
+	while (CatchUp > KINDA_SMALL_NUMBER)
+	{
+		const float StepTime = FMath::Min(CatchUp, ProjectileFixedStep);
+		RewindTime += StepTime;
+
+		if (StepProjectile(Index, StepTime, bAuthority ? RewindTime - ViewDelay : -1.0f) == false)
+		{
+			RemoveProjectile(Index);
+			return;
+		}
+		CatchUp -= StepTime;
+	}
+}
+
+void UProjectileSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProjectileSimulation);
+
+	Accumulator = FMath::Min(Accumulator + DeltaTime, ProjectileFixedStep * ProjectileMaxStepsPerFrame);
+	while (Accumulator >= ProjectileFixedStep)
+	{
+		Step(ProjectileFixedStep, -1.0f);
+		Accumulator -= ProjectileFixedStep;
+	}
+}
+
+void UProjectileSubsystem::Step(float StepTime, float RewindTime)
+{
+	// Backwards so RemoveAtSwap only moves projectiles that were already stepped
+	for (int32 i = Positions.Num() - 1; i >= 0; --i)
+	{
+		if (StepProjectile(i, StepTime, RewindTime) == false)
+		{
+			RemoveProjectile(i);
+		}
+	}
+}
+
+bool UProjectileSubsystem::StepProjectile(int32 Index, float StepTime, float RewindTime)
+{
+	AWeapon* Weapon = Weapons[Index].Get();
+	if (Weapon == nullptr)
+		return false;
+
+	Ages[Index] += StepTime;
+	if (Ages[Index] > Weapon->ProjectileLifetime)
+		return false;
+
+	const FVector Start = Positions[Index];
+	const FVector Gravity(0.0f, 0.0f, GetWorld()->GetGravityZ() * Weapon->ProjectileGravityScale);
+	const FVector NewVelocity = Velocities[Index] + Gravity * StepTime;
+	const FVector End = Start + (Velocities[Index] + NewVelocity) * (0.5f * StepTime);
+
+	Positions[Index] = End;
+	Velocities[Index] = NewVelocity;
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ProjectileSweep), false, Weapon);
+	QueryParams.AddIgnoredActor(Weapon->OwnChar);
+
+	// While rewinding, characters are tested against their recorded history rather than their live capsules
+	const bool bRewind = RewindTime >= 0.0f;
+	FCollisionObjectQueryParams ObjectParams(ECC_TO_BITFIELD(ECC_WorldStatic) | ECC_TO_BITFIELD(ECC_WorldDynamic));
+	if (bRewind == false)
+	{
+		ObjectParams.AddObjectTypesToQuery(ECC_Pawn);
+	}
+
+	FHitResult Hit;
+	const bool bHit = GetWorld()->LineTraceSingleByObjectType(Hit, Start, End, ObjectParams, QueryParams);
+	const FVector SegmentEnd = bHit ? Hit.ImpactPoint : End;
+
+	if (bRewind)
+	{
+		UCharacterSpatialIndex* SpatialIndex = GetWorld()->GetSubsystem<UCharacterSpatialIndex>();
+		const FVector Mid = (Start + SegmentEnd) * 0.5f;
+		const float HalfLength = FVector::Dist(Start, SegmentEnd) * 0.5f;
+
+		AShootingGameCharacter* RewoundHit = nullptr;
+		FVector RewoundPoint = SegmentEnd;
+		float BestDistSq = MAX_FLT;
+
+		SpatialIndex->ForEachInRadiusAtTime(Mid, HalfLength + 200.0f, RewindTime, ProjectileRewindSlack,
+			[&](AShootingGameCharacter* Char, const FVector& Location, float)
+		{
+			if (Char == Weapon->OwnChar)
+				return;
+
+			const UCapsuleComponent* Capsule = Char->GetCapsuleComponent();
+			const float Radius = Capsule->GetScaledCapsuleRadius();
+			const FVector Axis(0.0f, 0.0f, Capsule->GetScaledCapsuleHalfHeight_WithoutHemisphere());
+
+			FVector OnSegment, OnAxis;
+			FMath::SegmentDistToSegmentSafe(Start, SegmentEnd, Location - Axis, Location + Axis, OnSegment, OnAxis);
+			if (FVector::DistSquared(OnSegment, OnAxis) > Radius * Radius)
+				return;
+
+			const float DistSq = FVector::DistSquared(Start, OnSegment);
+			if (DistSq < BestDistSq)
+			{
+				BestDistSq = DistSq;
+				RewoundHit = Char;
+				RewoundPoint = OnSegment;
+			}
+		});
+
+		if (RewoundHit)
+		{
+			Hit = FHitResult(RewoundHit, RewoundHit->GetCapsuleComponent(), RewoundPoint, -NewVelocity.GetSafeNormal());
+			OnImpact(Index, Hit, RewoundHit);
+			return false;
+		}
+	}
+
+	if (bHit)
+	{
+		OnImpact(Index, Hit, Hit.GetActor());
+		return false;
+	}
+
+	return true;
+}
+
+void UProjectileSubsystem::OnImpact(int32 Index, const FHitResult& Hit, AActor* HitActor)
+{
+	AWeapon* Weapon = Weapons[Index].Get();
+
+	Weapon->OnProjectileImpact(Hit.ImpactPoint, Hit.ImpactNormal);
+
+	if (GetWorld()->GetNetMode() == NM_Client)
+		return;
+
+	AController* EventInstigator = Weapon->OwnChar ? Weapon->OwnChar->GetController() : nullptr;
+
+	if (Weapon->ExplosionRadius > 0.0f)
+	{
+		UExplosionSubsystem* Explosions = GetWorld()->GetSubsystem<UExplosionSubsystem>();
+		Explosions->QueueExplosion(Hit.ImpactPoint, Weapon->ExplosionRadius, Weapon->Damage, Weapon->ExplosionMinDamage, Weapon->ExplosionFalloff, EventInstigator, Weapon);
+		return;
+	}
+
+	ACharacter* HitChar = Cast<ACharacter>(HitActor);
+	AShootingGameCharacter* HitShooter = Cast<AShootingGameCharacter>(HitChar);
+	if (HitShooter && HitShooter->CanBeDamagedBy(EventInstigator, AShootingPlayerState::GetDamageMask(EventInstigator)) == false)
+		return;
+
+	if (HitChar)
+	{
+		UGameplayStatics::ApplyDamage(HitChar, Weapon->Damage, EventInstigator, Weapon, UDamageType::StaticClass());
+	}
+}
+
+void UProjectileSubsystem::RemoveProjectile(int32 Index)
+{
+	Positions.RemoveAtSwap(Index, 1, false);
+	Velocities.RemoveAtSwap(Index, 1, false);
+	Ages.RemoveAtSwap(Index, 1, false);
+	Weapons.RemoveAtSwap(Index, 1, false);
+	DEC_DWORD_STAT(STAT_Projectiles);
+}
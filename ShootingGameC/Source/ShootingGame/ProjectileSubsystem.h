@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ProjectileSubsystem.generated.h"
+
+class AWeapon;
+
+/**
+ * Simulates every ballistic projectile of the world without actors.
+ * State is kept as parallel arrays and advanced at a fixed step with one sweep per projectile per step.
+ * Only the spawn event (origin, direction, seed, server time) crosses the network; each machine simulates
+ * the flight itself and only the server applies damage.
+ */
+UCLASS()
+class SHOOTINGGAME_API UProjectileSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/**
+	 * Starts a projectile fired by Weapon at ServerTime. Projectiles fired in the past are fast-forwarded to now;
+	 * on the server that catch-up is tested against characters rewound to where they were.
+	 */
+	void SpawnProjectile(AWeapon* Weapon, const FVector& Origin, const FVector& Direction, int32 Seed, float ServerTime);
+
+	/** Current time on the server's clock, as used for projectile timestamps */
+	double GetServerTime() const;
+
+	FORCEINLINE int32 Num() const { return Positions.Num(); }
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return Positions.Num() > 0; }
+	virtual ETickableTickType GetTickableTickType() const override { return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional; }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(UProjectileSubsystem, STATGROUP_Tickables); }
+
+private:
+	/** Advances every projectile by StepTime. RewindTime >= 0 tests characters at that past time instead of their live collision. */
+	void Step(float StepTime, float RewindTime);
+
+	/** Advances a single projectile, returns false once it hit something or expired */
+	bool StepProjectile(int32 Index, float StepTime, float RewindTime);
+
+	void OnImpact(int32 Index, const FHitResult& Hit, AActor* HitActor);
+
+	void RemoveProjectile(int32 Index);
+
+	TArray<FVector> Positions;
+
+	TArray<FVector> Velocities;
+
+	TArray<float> Ages;
+
+	TArray<TWeakObjectPtr<AWeapon>> Weapons;
+
+	float Accumulator;
+};
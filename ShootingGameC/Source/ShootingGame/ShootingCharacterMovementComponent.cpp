@@ -0,0 +1,607 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShootingCharacterMovementComponent.h"
+#include "ShootingGame.h"
+#include "ShootingGameCharacter.h"
+#include "CharacterSpatialIndex.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/CapsuleComponent.h"
+#include "NavigationSystem.h"
+#include "NetClockSyncComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Simplified Movement"), STAT_SimplifiedMovement, STATGROUP_ShootingGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Simplified Moves"), STAT_SimplifiedMoves, STATGROUP_ShootingGame);
+DECLARE_CYCLE_STAT(TEXT("Input Intent"), STAT_InputIntent, STATGROUP_ShootingGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Simplified Proxies"), STAT_SimplifiedProxies, STATGROUP_ShootingGame);
+DECLARE_CYCLE_STAT(TEXT("Snapshot Interpolation"), STAT_SnapshotInterpolation, STATGROUP_ShootingGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Extrapolated Proxies"), STAT_ExtrapolatedProxies, STATGROUP_ShootingGame);
+
+static TAutoConsoleVariable<int32> CVarSimplifiedMovement(
+	TEXT("sg.SimplifiedMovement"),
+	1,
+	TEXT("Use simplified movement for bots and simulated proxies far from every player.\n")
+	TEXT("0: always run the full character movement, 1: switch by distance"));
+
+static TAutoConsoleVariable<int32> CVarSnapshotInterpolation(
+	TEXT("sg.SnapshotInterpolation"),
+	1,
+	TEXT("Render simulated proxies from a jitter buffer of replicated snapshots.\n")
+	TEXT("0: default simulation and smoothing, 1: snapshot interpolation"));
+
+//////////////////////////////////////////////////////////////////////////
+// FSavedMove_Shooting
+
+void FSavedMove_Shooting::Clear()
+{
+	Super::Clear();
+
+	bPressedFire = false;
+	bPressedReload = false;
+}
+
+uint8 FSavedMove_Shooting::GetCompressedFlags() const
+{
+	uint8 Result = Super::GetCompressedFlags();
+
+	if (bPressedFire)
+	{
+		Result |= FLAG_Custom_0;
+	}
+
+	if (bPressedReload)
+	{
+		Result |= FLAG_Custom_1;
+	}
+
+	return Result;
+}
+
+bool FSavedMove_Shooting::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	// A press must reach the server in its own move
+	if (bPressedFire || bPressedReload || ((FSavedMove_Shooting*)NewMove.Get())->bPressedFire || ((FSavedMove_Shooting*)NewMove.Get())->bPressedReload)
+		return false;
+
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_Shooting::SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+
+	UShootingCharacterMovementComponent* Movement = Cast<UShootingCharacterMovementComponent>(C->GetCharacterMovement());
+	if (Movement)
+	{
+		bPressedFire = Movement->bPressedFire;
+		bPressedReload = Movement->bPressedReload;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FNetworkPredictionData_Client_Shooting
+
+FNetworkPredictionData_Client_Shooting::FNetworkPredictionData_Client_Shooting(const UCharacterMovementComponent& ClientMovement)
+	: Super(ClientMovement)
+{
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_Shooting::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_Shooting());
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FShootingCharacterNetworkMoveData
+
+bool FShootingCharacterNetworkMoveData::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType)
+{
+	NetworkMoveType = MoveType;
+
+	bool bLocalSuccess = true;
+	const bool bIsSaving = Ar.IsSaving();
+	const float MaxAccel = CharacterMovement.GetMaxAcceleration();
+
+	Ar << TimeStamp;
+
+	// Acceleration: one bit when zero, otherwise a signed byte per axis
+	uint8 bHasAcceleration = bIsSaving ? !Acceleration.IsZero() : 0;
+	Ar.SerializeBits(&bHasAcceleration, 1);
+	if (bHasAcceleration)
+	{
+		int8 Packed[3];
+		if (bIsSaving)
+		{
+			Packed[0] = UShootingCharacterMovementComponent::QuantizeAccelerationAxis(Acceleration.X, MaxAccel);
+			Packed[1] = UShootingCharacterMovementComponent::QuantizeAccelerationAxis(Acceleration.Y, MaxAccel);
+			Packed[2] = UShootingCharacterMovementComponent::QuantizeAccelerationAxis(Acceleration.Z, MaxAccel);
+		}
+		Ar << Packed[0] << Packed[1] << Packed[2];
+		if (bIsSaving == false)
+		{
+			Acceleration.X = UShootingCharacterMovementComponent::DequantizeAccelerationAxis(Packed[0], MaxAccel);
+			Acceleration.Y = UShootingCharacterMovementComponent::DequantizeAccelerationAxis(Packed[1], MaxAccel);
+			Acceleration.Z = UShootingCharacterMovementComponent::DequantizeAccelerationAxis(Packed[2], MaxAccel);
+		}
+	}
+	else if (bIsSaving == false)
+	{
+		Acceleration = FVector::ZeroVector;
+	}
+
+	// View: yaw and pitch only, the shooter never rolls the controller
+	uint16 Yaw = FRotator::CompressAxisToShort(ControlRotation.Yaw);
+	uint16 Pitch = FRotator::CompressAxisToShort(ControlRotation.Pitch);
+	Ar << Yaw << Pitch;
+	if (bIsSaving == false)
+	{
+		ControlRotation = FRotator(FRotator::DecompressAxisFromShort(Pitch), FRotator::DecompressAxisFromShort(Yaw), 0.0f);
+	}
+
+	SerializeOptionalValue<uint8>(bIsSaving, Ar, CompressedMoveFlags, 0);
+
+	if (MoveType == ENetworkMoveType::NewMove)
+	{
+		// Location, base and movement mode are only used for error checking, so only the final move carries them
+		Location.NetSerialize(Ar, PackageMap, bLocalSuccess);
+		SerializeOptionalValue<UPrimitiveComponent*>(bIsSaving, Ar, MovementBase, nullptr);
+		SerializeOptionalValue<FName>(bIsSaving, Ar, MovementBaseBoneName, NAME_None);
+		SerializeOptionalValue<uint8>(bIsSaving, Ar, MovementMode, MOVE_Walking);
+	}
+
+	return !Ar.IsError() && bLocalSuccess;
+}
+
+FShootingCharacterNetworkMoveDataContainer::FShootingCharacterNetworkMoveDataContainer()
+{
+	NewMoveData = &MoveData[0];
+	PendingMoveData = &MoveData[1];
+	OldMoveData = &MoveData[2];
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FShootingCharacterMoveResponseDataContainer
+
+void FShootingCharacterMoveResponseDataContainer::ServerFillResponseData(const UCharacterMovementComponent& CharacterMovement, const FClientAdjustment& PendingAdjustment)
+{
+	Super::ServerFillResponseData(CharacterMovement, PendingAdjustment);
+
+	if (CharacterMovement.bOrientRotationToMovement)
+	{
+		bHasRotation = false;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FMoveSnapshotBuffer
+
+FMoveSnapshotBuffer::FMoveSnapshotBuffer()
+{
+	Head = 0;
+	NumSnapshots = 0;
+	LastReceiveTime = 0.0f;
+	Interval = 0.0f;
+	Jitter = 0.0f;
+	TransitTime = 0.0f;
+	Delay = 0.1f;
+	bHasTransitTime = false;
+	bHasDelay = false;
+}
+
+bool FMoveSnapshotBuffer::Add(const FSnapshot& Snapshot, float ReceiveServerTime, float TeleportDistance)
+{
+	if (NumSnapshots > 0 && Snapshot.ServerTime <= Snapshots[Head].ServerTime)
+		return false;
+
+	// Transit includes the error of the local server time estimate, which render time shares, so the two cancel
+	const float Transit = ReceiveServerTime - Snapshot.ServerTime;
+	if (bHasTransitTime)
+	{
+		TransitTime += (Transit - TransitTime) / 8.0f;
+	}
+	else
+	{
+		TransitTime = Transit;
+		bHasTransitTime = true;
+	}
+
+	// Arrival jitter is how far the gap between receipts strays from the gap between send stamps
+	if (NumSnapshots > 0)
+	{
+		const float SendDelta = Snapshot.ServerTime - Snapshots[Head].ServerTime;
+		const float ReceiveDelta = ReceiveServerTime - LastReceiveTime;
+		Interval += (SendDelta - Interval) / 8.0f;
+		Jitter += (FMath::Abs(ReceiveDelta - SendDelta) - Jitter) / 8.0f;
+
+		if (FVector::DistSquared(Snapshot.Location, Snapshots[Head].Location) > FMath::Square(TeleportDistance))
+		{
+			NumSnapshots = 0;
+		}
+	}
+	LastReceiveTime = ReceiveServerTime;
+
+	Head = (Head + 1) % BufferSize;
+	NumSnapshots = FMath::Min(NumSnapshots + 1, BufferSize);
+	Snapshots[Head] = Snapshot;
+
+	return true;
+}
+
+bool FMoveSnapshotBuffer::AddPitch(float ServerTime, float Pitch, float ReceiveServerTime)
+{
+	if (NumSnapshots == 0)
+		return false;
+
+	FSnapshot Snapshot = Snapshots[Head];
+	Snapshot.ServerTime = ServerTime;
+	Snapshot.Pitch = Pitch;
+	return Add(Snapshot, ReceiveServerTime, 0.0f);
+}
+
+void FMoveSnapshotBuffer::UpdateDelay(float DeltaSeconds, float MinBufferTime, float MaxBufferTime, float JitterScale)
+{
+	// Enough delay for a snapshot to arrive, plus one snapshot interval and the arrival jitter on top
+	const float TargetDelay = FMath::Max(TransitTime + FMath::Clamp(Interval + Jitter * JitterScale, MinBufferTime, MaxBufferTime), 0.0f);
+	Delay = bHasDelay ? FMath::FInterpConstantTo(Delay, TargetDelay, DeltaSeconds, 0.1f) : TargetDelay;
+	bHasDelay = true;
+}
+
+bool FMoveSnapshotBuffer::Evaluate(float RenderTime, float MaxExtrapolationTime, FSnapshot& Out) const
+{
+	Out.ServerTime = RenderTime;
+
+	if (NumSnapshots == 0)
+		return false;
+
+	// Newest snapshot at or before RenderTime
+	int32 Age = 0;
+	while (Age < NumSnapshots - 1 && Snapshots[GetSlot(Age)].ServerTime > RenderTime)
+	{
+		++Age;
+	}
+
+	const FSnapshot& A = Snapshots[GetSlot(Age)];
+
+	if (Age == 0 || A.ServerTime > RenderTime)
+	{
+		// Past the newest snapshot (or before the oldest): hold, or carry on along the last velocity for a bounded time
+		const float Extrapolation = FMath::Clamp(RenderTime - A.ServerTime, 0.0f, MaxExtrapolationTime);
+
+		Out.Location = A.Location + A.Velocity * Extrapolation;
+		Out.Rotation = A.Rotation;
+		Out.Velocity = A.Velocity;
+		Out.Pitch = A.Pitch;
+		return Extrapolation > 0.0f;
+	}
+
+	const FSnapshot& B = Snapshots[GetSlot(Age - 1)];
+	const FSnapshot& Prev = Snapshots[GetSlot(FMath::Min(Age + 1, NumSnapshots - 1))];
+	const FSnapshot& Next = Snapshots[GetSlot(FMath::Max(Age - 2, 0))];
+
+	const float Span = FMath::Max(B.ServerTime - A.ServerTime, KINDA_SMALL_NUMBER);
+	const float Alpha = FMath::Clamp((RenderTime - A.ServerTime) / Span, 0.0f, 1.0f);
+
+	// Hermite on position with the replicated velocities as tangents
+	Out.Location = FMath::CubicInterp(A.Location, A.Velocity * Span, B.Location, B.Velocity * Span, Alpha);
+	Out.Velocity = FMath::Lerp(A.Velocity, B.Velocity, Alpha);
+
+	// Rotation and aim use tangents from the neighbouring snapshots
+	FQuat TangentA, TangentB;
+	FQuat::CalcTangents(Prev.Rotation, A.Rotation, B.Rotation, 0.0f, TangentA);
+	FQuat::CalcTangents(A.Rotation, B.Rotation, Next.Rotation, 0.0f, TangentB);
+	Out.Rotation = FQuat::Squad(A.Rotation, TangentA, B.Rotation, TangentB, Alpha);
+
+	const float PitchB = A.Pitch + FRotator::NormalizeAxis(B.Pitch - A.Pitch);
+	const float PitchTangentA = (PitchB - (A.Pitch + FRotator::NormalizeAxis(Prev.Pitch - A.Pitch))) * 0.5f;
+	const float PitchTangentB = ((PitchB + FRotator::NormalizeAxis(Next.Pitch - B.Pitch)) - A.Pitch) * 0.5f;
+	Out.Pitch = FMath::CubicInterp(A.Pitch, PitchTangentA, PitchB, PitchTangentB, Alpha);
+
+	return false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UShootingCharacterMovementComponent
+
+UShootingCharacterMovementComponent::UShootingCharacterMovementComponent()
+{
+	bPressedFire = false;
+	bPressedReload = false;
+
+	SimplifiedMovementDistance = 5000.0f;
+	SignificanceInterval = 0.5f;
+	SimplifiedFloorCheckInterval = 0.25f;
+	NextSignificanceTime = 0.0f;
+	NextFloorCheckTime = 0.0f;
+	bUseSimplifiedMovement = false;
+
+	MinInterpolationDelay = 0.05f;
+	MaxInterpolationDelay = 0.3f;
+	InterpolationJitterScale = 2.0f;
+	MaxExtrapolationTime = 0.25f;
+	SnapshotTeleportDistance = 1000.0f;
+	InterpolatedPitch = 0.0f;
+	bHasInterpolatedPitch = false;
+
+	SetNetworkMoveDataContainer(ShootingMoveDataContainer);
+	SetMoveResponseDataContainer(ShootingMoveResponseDataContainer);
+}
+
+FNetworkPredictionData_Client* UShootingCharacterMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr)
+	{
+		UShootingCharacterMovementComponent* MutableThis = const_cast<UShootingCharacterMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Shooting(*this);
+	}
+
+	return ClientPredictionData;
+}
+
+void UShootingCharacterMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	// Moves are replayed locally after corrections; only the server acts on the presses
+	if (CharacterOwner == nullptr || CharacterOwner->GetLocalRole() != ROLE_Authority)
+		return;
+
+	AShootingGameCharacter* Char = Cast<AShootingGameCharacter>(CharacterOwner);
+	if (Char == nullptr)
+		return;
+
+	if (Flags & FSavedMove_Character::FLAG_Custom_0)
+	{
+		Char->ReqPressTrigger();
+	}
+
+	if (Flags & FSavedMove_Character::FLAG_Custom_1)
+	{
+		Char->ReqPressReload();
+	}
+}
+
+FVector UShootingCharacterMovementComponent::RoundAcceleration(FVector InAccel) const
+{
+	if (IsNetMode(NM_Standalone))
+		return Super::RoundAcceleration(InAccel);
+
+	const float MaxAccel = GetMaxAcceleration();
+	return FVector(
+		DequantizeAccelerationAxis(QuantizeAccelerationAxis(InAccel.X, MaxAccel), MaxAccel),
+		DequantizeAccelerationAxis(QuantizeAccelerationAxis(InAccel.Y, MaxAccel), MaxAccel),
+		DequantizeAccelerationAxis(QuantizeAccelerationAxis(InAccel.Z, MaxAccel), MaxAccel));
+}
+
+int8 UShootingCharacterMovementComponent::QuantizeAccelerationAxis(float Value, float MaxAccel)
+{
+	if (MaxAccel <= 0.0f)
+		return 0;
+
+	return (int8)FMath::Clamp(FMath::RoundToInt(Value / MaxAccel * 127.0f), -127, 127);
+}
+
+float UShootingCharacterMovementComponent::DequantizeAccelerationAxis(int8 Value, float MaxAccel)
+{
+	return Value * MaxAccel / 127.0f;
+}
+
+void UShootingCharacterMovementComponent::ReplicateMoveToServer(float DeltaTime, const FVector& NewAcceleration)
+{
+	Super::ReplicateMoveToServer(DeltaTime, NewAcceleration);
+
+	// The presses are now in a saved move, which is resent until acknowledged
+	bPressedFire = false;
+	bPressedReload = false;
+}
+
+void UShootingCharacterMovementComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	UpdateSignificance();
+
+	// Runs after the controller processed input, so the intent gathered this frame moves the character this frame
+	AShootingGameCharacter* Char = Cast<AShootingGameCharacter>(CharacterOwner);
+	if (Char && Char->IsLocallyControlled())
+	{
+		SCOPE_CYCLE_COUNTER(STAT_InputIntent);
+		Char->ApplyInputIntent(DeltaTime);
+	}
+
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+}
+
+void UShootingCharacterMovementComponent::UpdateSignificance()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	if (CharacterOwner == nullptr || Now < NextSignificanceTime)
+		return;
+
+	NextSignificanceTime = Now + SignificanceInterval;
+
+	bool bSimplify = false;
+	if (CVarSimplifiedMovement.GetValueOnGameThread() != 0)
+	{
+		const ENetRole Role = CharacterOwner->GetLocalRole();
+		if (Role == ROLE_SimulatedProxy)
+		{
+			APlayerController* pc = GetWorld()->GetFirstPlayerController();
+			if (pc && pc->PlayerCameraManager)
+			{
+				bSimplify = FVector::DistSquared(pc->PlayerCameraManager->GetCameraLocation(), GetActorLocation()) > FMath::Square(SimplifiedMovementDistance);
+			}
+		}
+		else if (Role == ROLE_Authority && CharacterOwner->GetController() && CharacterOwner->IsPlayerControlled() == false)
+		{
+			bSimplify = true;
+
+			UCharacterSpatialIndex* SpatialIndex = GetWorld()->GetSubsystem<UCharacterSpatialIndex>();
+			if (SpatialIndex)
+			{
+				SpatialIndex->ForEachInRadius(GetActorLocation(), SimplifiedMovementDistance, [&](AShootingGameCharacter* Char, const FVector& Location, float DistSq)
+				{
+					if (Char->IsPlayerControlled())
+					{
+						bSimplify = false;
+					}
+				});
+			}
+		}
+	}
+
+	if (bSimplify != bUseSimplifiedMovement)
+	{
+		bUseSimplifiedMovement = bSimplify;
+		NextFloorCheckTime = 0.0f;
+	}
+}
+
+void UShootingCharacterMovementComponent::PerformMovement(float DeltaTime)
+{
+	if (bUseSimplifiedMovement && PerformSimplifiedMovement(DeltaTime))
+		return;
+
+	Super::PerformMovement(DeltaTime);
+}
+
+bool UShootingCharacterMovementComponent::PerformSimplifiedMovement(float DeltaTime)
+{
+	if (MovementMode != MOVE_Walking || UpdatedComponent == nullptr || HasAnimRootMotion() || CurrentRootMotion.HasActiveRootMotionSources())
+		return false;
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (NavSys == nullptr)
+		return false;
+
+	SCOPE_CYCLE_COUNTER(STAT_SimplifiedMovement);
+
+	const FVector OldVelocity = Velocity;
+	CalcVelocity(DeltaTime, GroundFriction, false, GetMaxBrakingDeceleration());
+	Velocity.Z = 0.0f;
+
+	const float HalfHeight = CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	const FVector Feet = UpdatedComponent->GetComponentLocation() + Velocity * DeltaTime - FVector(0.0f, 0.0f, HalfHeight);
+
+	// Off the navmesh the full simulation decides what happens
+	FNavLocation NavLocation;
+	if (NavSys->ProjectPointToNavigation(Feet, NavLocation, FVector(50.0f, 50.0f, HalfHeight)) == false)
+	{
+		Velocity = OldVelocity;
+		return false;
+	}
+
+	INC_DWORD_STAT(STAT_SimplifiedMoves);
+
+	UpdatedComponent->SetWorldLocation(NavLocation.Location + FVector(0.0f, 0.0f, HalfHeight), false);
+
+	// The navmesh only approximates the floor height, so snap to the real floor now and then
+	const float Now = GetWorld()->GetTimeSeconds();
+	if (Now >= NextFloorCheckTime)
+	{
+		NextFloorCheckTime = Now + SimplifiedFloorCheckInterval;
+
+		FindFloor(UpdatedComponent->GetComponentLocation(), CurrentFloor, nullptr);
+		if (CurrentFloor.IsWalkableFloor())
+		{
+			AdjustFloorHeight();
+		}
+		else
+		{
+			SetMovementMode(MOVE_Falling);
+		}
+	}
+
+	PhysicsRotation(DeltaTime);
+	UpdateComponentVelocity();
+
+	return true;
+}
+
+void UShootingCharacterMovementComponent::SimulatedTick(float DeltaSeconds)
+{
+	if (ShouldUseSnapshots() && Snapshots.Num() > 0)
+	{
+		InterpolateSnapshots(DeltaSeconds);
+		return;
+	}
+
+	if (bUseSimplifiedMovement == false || CharacterOwner->IsPlayingNetworkedRootMotionMontage())
+	{
+		Super::SimulatedTick(DeltaSeconds);
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_SimplifiedProxies);
+
+	// No extrapolation: the capsule stays where replication put it and only the mesh is smoothed toward it
+	SmoothClientPosition(DeltaSeconds);
+}
+
+bool UShootingCharacterMovementComponent::ShouldUseSnapshots() const
+{
+	// Distant proxies keep the cheaper simplified path, root motion keeps the engine's own handling
+	return CVarSnapshotInterpolation.GetValueOnGameThread() != 0 && bUseSimplifiedMovement == false && CharacterOwner && CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy
+		&& CharacterOwner->IsPlayingNetworkedRootMotionMontage() == false;
+}
+
+void UShootingCharacterMovementComponent::SmoothCorrection(const FVector& OldLocation, const FQuat& OldRotation, const FVector& NewLocation, const FQuat& NewRotation)
+{
+	AShootingGameCharacter* Char = Cast<AShootingGameCharacter>(CharacterOwner);
+	if (ShouldUseSnapshots() == false || Char == nullptr)
+	{
+		bHasInterpolatedPitch = false;
+		Snapshots.Reset();
+		Super::SmoothCorrection(OldLocation, OldRotation, NewLocation, NewRotation);
+		return;
+	}
+
+	// The character's own replicated timestamp is the client's move time for player-controlled characters, so use the server stamp sent with this state
+	FMoveSnapshotBuffer::FSnapshot Snapshot;
+	Snapshot.ServerTime = Char->GetReplicatedMovementTime();
+	Snapshot.Location = NewLocation;
+	Snapshot.Rotation = NewRotation;
+	Snapshot.Velocity = Velocity;
+	Snapshot.Pitch = FRotator::NormalizeAxis(Char->GetReplicatedControlPitch());
+
+	Snapshots.Add(Snapshot, (float)UNetClockSyncComponent::GetServerTime(GetWorld()), SnapshotTeleportDistance);
+
+	// The pose is set by InterpolateSnapshots, so the mesh needs no smoothing offset
+	bNetworkSmoothingComplete = true;
+}
+
+void UShootingCharacterMovementComponent::InterpolateSnapshots(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SnapshotInterpolation);
+
+	// Aiming in place re-stamps the movement time without moving, so no SmoothCorrection brings that state in
+	AShootingGameCharacter* Char = Cast<AShootingGameCharacter>(CharacterOwner);
+	if (Char)
+	{
+		Snapshots.AddPitch(Char->GetReplicatedMovementTime(), FRotator::NormalizeAxis(Char->GetReplicatedControlPitch()), (float)UNetClockSyncComponent::GetServerTime(GetWorld()));
+	}
+
+	Snapshots.UpdateDelay(DeltaSeconds, MinInterpolationDelay, MaxInterpolationDelay, InterpolationJitterScale);
+
+	UNetClockSyncComponent* Clock = UNetClockSyncComponent::GetLocal(GetWorld());
+	if (Clock)
+	{
+		Clock->NoteInterpolationDelay(Snapshots.GetDelay());
+	}
+
+	const float RenderTime = (float)(UNetClockSyncComponent::GetServerTime(GetWorld()) - Snapshots.GetDelay());
+
+	FMoveSnapshotBuffer::FSnapshot Pose;
+	if (Snapshots.Evaluate(RenderTime, MaxExtrapolationTime, Pose))
+	{
+		INC_DWORD_STAT(STAT_ExtrapolatedProxies);
+	}
+
+	Velocity = Pose.Velocity;
+
+	// Same 0-360 convention as the replicated ControlPitch
+	InterpolatedPitch = FRotator::ClampAxis(Pose.Pitch);
+	bHasInterpolatedPitch = true;
+
+	UpdatedComponent->SetWorldLocationAndRotation(Pose.Location, Pose.Rotation, false, nullptr, ETeleportType::None);
+	UpdateComponentVelocity();
+}
@@ -0,0 +1,235 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "ShootingCharacterMovementComponent.generated.h"
+
+/** Saved move that also carries the fire and reload presses of its frame */
+class FSavedMove_Shooting : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	virtual void Clear() override;
+	virtual uint8 GetCompressedFlags() const override;
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, class FNetworkPredictionData_Client_Character& ClientData) override;
+
+	uint8 bPressedFire : 1;
+	uint8 bPressedReload : 1;
+};
+
+class FNetworkPredictionData_Client_Shooting : public FNetworkPredictionData_Client_Character
+{
+public:
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	FNetworkPredictionData_Client_Shooting(const UCharacterMovementComponent& ClientMovement);
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
+
+/**
+ * Move data with 8 bit acceleration per axis and a roll-free 2x16 bit view.
+ * Acceleration is rounded to the same grid on the client before simulating, so the smaller packet causes no extra corrections.
+ */
+struct FShootingCharacterNetworkMoveData : public FCharacterNetworkMoveData
+{
+	typedef FCharacterNetworkMoveData Super;
+
+	virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType) override;
+};
+
+struct FShootingCharacterNetworkMoveDataContainer : public FCharacterNetworkMoveDataContainer
+{
+	FShootingCharacterNetworkMoveDataContainer();
+
+	FShootingCharacterNetworkMoveData MoveData[3];
+};
+
+/** Correction that leaves out the rotation, which the client derives from velocity anyway when orienting to movement */
+struct FShootingCharacterMoveResponseDataContainer : public FCharacterMoveResponseDataContainer
+{
+	typedef FCharacterMoveResponseDataContainer Super;
+
+	virtual void ServerFillResponseData(const UCharacterMovementComponent& CharacterMovement, const FClientAdjustment& PendingAdjustment) override;
+};
+
+/**
+ * Jitter buffer of a simulated proxy's replicated movement, stamped with the server time each state was sent.
+ * Kept free of the engine so the interpolation can be replayed against a packet trace on its own.
+ */
+struct FMoveSnapshotBuffer
+{
+	struct FSnapshot
+	{
+		float ServerTime;
+		FVector Location;
+		FQuat Rotation;
+		FVector Velocity;
+		float Pitch;
+	};
+
+	FMoveSnapshotBuffer();
+
+	FORCEINLINE int32 Num() const { return NumSnapshots; }
+
+	FORCEINLINE void Reset() { NumSnapshots = 0; }
+
+	/** How far behind server time the buffer is played back: transit time plus room for one interval and the jitter */
+	FORCEINLINE float GetDelay() const { return Delay; }
+
+	FORCEINLINE float GetTransitTime() const { return TransitTime; }
+
+	FORCEINLINE float GetJitter() const { return Jitter; }
+
+	/** Adds a state sent at Snapshot.ServerTime and received at ReceiveServerTime, both in server time. Returns false for a repeated state. */
+	bool Add(const FSnapshot& Snapshot, float ReceiveServerTime, float TeleportDistance);
+
+	/** Repeats the newest pose at a later ServerTime with a new pitch, for a character that aimed without moving. Returns false if not newer. */
+	bool AddPitch(float ServerTime, float Pitch, float ReceiveServerTime);
+
+	/** Eases the delay toward its target so playback speed changes by at most 10%; the first call takes the target at once */
+	void UpdateDelay(float DeltaSeconds, float MinBufferTime, float MaxBufferTime, float JitterScale);
+
+	/** Pose at RenderTime. Returns true when past the newest snapshot and carrying on along its velocity. */
+	bool Evaluate(float RenderTime, float MaxExtrapolationTime, FSnapshot& Out) const;
+
+private:
+	FORCEINLINE int32 GetSlot(int32 Age) const { return (Head - Age + BufferSize) % BufferSize; }
+
+	static const int32 BufferSize = 16;
+
+	FSnapshot Snapshots[BufferSize];
+
+	/** Slot of the newest snapshot */
+	int32 Head;
+
+	int32 NumSnapshots;
+
+	float LastReceiveTime;
+
+	/** Smoothed send spacing, arrival variation around it, and time from send to receipt */
+	float Interval;
+
+	float Jitter;
+
+	float TransitTime;
+
+	float Delay;
+
+	uint8 bHasTransitTime : 1;
+
+	uint8 bHasDelay : 1;
+};
+
+/**
+ * Movement component for AShootingGameCharacter.
+ * Sends compressed moves, folds fire and reload into the move flags instead of separate server RPCs,
+ * and trims the correction payload.
+ */
+UCLASS()
+class SHOOTINGGAME_API UShootingCharacterMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	UShootingCharacterMovementComponent();
+
+	virtual class FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+
+	/** Quantizes acceleration to the grid FShootingCharacterNetworkMoveData sends */
+	virtual FVector RoundAcceleration(FVector InAccel) const override;
+
+	static int8 QuantizeAccelerationAxis(float Value, float MaxAccel);
+
+	static float DequantizeAccelerationAxis(int8 Value, float MaxAccel);
+
+	FORCEINLINE bool IsUsingSimplifiedMovement() const { return bUseSimplifiedMovement; }
+
+	/** Simulated proxies: aim pitch at the current interpolation time, valid once HasInterpolatedPitch */
+	FORCEINLINE float GetInterpolatedPitch() const { return InterpolatedPitch; }
+
+	FORCEINLINE bool HasInterpolatedPitch() const { return bHasInterpolatedPitch; }
+
+	FORCEINLINE float GetInterpolationDelay() const { return Snapshots.GetDelay(); }
+
+	virtual void SmoothCorrection(const FVector& OldLocation, const FQuat& OldRotation, const FVector& NewLocation, const FQuat& NewRotation) override;
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+	virtual void ReplicateMoveToServer(float DeltaTime, const FVector& NewAcceleration) override;
+
+	virtual void PerformMovement(float DeltaTime) override;
+
+	virtual void SimulatedTick(float DeltaSeconds) override;
+
+private:
+	/** Switches simplified movement on for server bots and simulated proxies that no player is near */
+	void UpdateSignificance();
+
+	/** Walks along the navmesh without sweeps. Returns false when the full simulation has to handle this frame. */
+	bool PerformSimplifiedMovement(float DeltaTime);
+
+	bool ShouldUseSnapshots() const;
+
+	/** Places a simulated proxy at the snapshot-interpolated pose for the current render time */
+	void InterpolateSnapshots(float DeltaSeconds);
+
+public:
+	/** Set by input on the owning client and sent with the next move */
+	uint8 bPressedFire : 1;
+	uint8 bPressedReload : 1;
+
+	/** Bots and simulated proxies farther than this from every player use simplified movement */
+	UPROPERTY(EditAnywhere, Category = "Simplified Movement")
+	float SimplifiedMovementDistance;
+
+	UPROPERTY(EditAnywhere, Category = "Simplified Movement")
+	float SignificanceInterval;
+
+	/** How often a simplified bot sweeps for the real floor */
+	UPROPERTY(EditAnywhere, Category = "Simplified Movement")
+	float SimplifiedFloorCheckInterval;
+
+	/** Simulated proxies render the measured transit time plus this much buffer behind the estimated server time, adapted between these bounds */
+	UPROPERTY(EditAnywhere, Category = "Snapshot Interpolation")
+	float MinInterpolationDelay;
+
+	UPROPERTY(EditAnywhere, Category = "Snapshot Interpolation")
+	float MaxInterpolationDelay;
+
+	/** Extra delay per second of measured arrival jitter */
+	UPROPERTY(EditAnywhere, Category = "Snapshot Interpolation")
+	float InterpolationJitterScale;
+
+	/** How long a proxy keeps moving on its last velocity once snapshots stop arriving */
+	UPROPERTY(EditAnywhere, Category = "Snapshot Interpolation")
+	float MaxExtrapolationTime;
+
+	/** A jump larger than this between snapshots is a teleport and restarts the buffer */
+	UPROPERTY(EditAnywhere, Category = "Snapshot Interpolation")
+	float SnapshotTeleportDistance;
+
+private:
+	FShootingCharacterNetworkMoveDataContainer ShootingMoveDataContainer;
+
+	FShootingCharacterMoveResponseDataContainer ShootingMoveResponseDataContainer;
+
+	float NextSignificanceTime;
+
+	float NextFloorCheckTime;
+
+	uint8 bUseSimplifiedMovement : 1;
+
+	FMoveSnapshotBuffer Snapshots;
+
+	float InterpolatedPitch;
+
+	uint8 bHasInterpolatedPitch : 1;
+};
@@ -4,4 +4,18 @@
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, ShootingGame, "ShootingGame" );
+
+DEFINE_LOG_CATEGORY(LogShootingGame);
+
+#if !UE_BUILD_SHIPPING
+static TAutoConsoleVariable<int32> CVarDebugMessages(
+	TEXT("sg.DebugMessages"),
+	1,
+	TEXT("Show on-screen combat debug messages. Turn off when profiling, each message formats a string."));
+
+bool ShouldShowDebugMessages()
+{
+	return CVarDebugMessages.GetValueOnGameThread() != 0;
+}
+#endif
  
\ No newline at end of file
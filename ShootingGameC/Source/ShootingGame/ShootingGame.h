@@ -3,3 +3,22 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogShootingGame, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("ShootingGame"), STATGROUP_ShootingGame, STATCAT_Advanced);
+
+/** On-screen debug message that is compiled out of shipping builds and only formatted while sg.DebugMessages is on */
+#if UE_BUILD_SHIPPING
+#define SHOOTING_DEBUG_MESSAGE(Format, ...) do { } while (0)
+#else
+SHOOTINGGAME_API bool ShouldShowDebugMessages();
+
+#define SHOOTING_DEBUG_MESSAGE(Format, ...) \
+	do \
+	{ \
+		if (GEngine && ShouldShowDebugMessages()) \
+			GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Yellow, FString::Printf(Format, ##__VA_ARGS__)); \
+	} while (0)
+#endif
@@ -1,6 +1,7 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "ShootingGameCharacter.h"
+#include "ShootingGame.h"
 #include "HeadMountedDisplayFunctionLibrary.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
@@ -9,18 +10,33 @@
 #include "GameFramework/Controller.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "WeaponInterface.h"
 #include "ShootingPlayerState.h"
 #include "Weapon.h"
 #include "TimerManager.h"
 #include "Blueprint/UserWidget.h"
 #include "NameTagInterface.h"
+#include "ShootingGameGameMode.h"
+#include "WeaponInventoryComponent.h"
+#include "CharacterSpatialIndex.h"
+#include "CharacterTickSubsystem.h"
+#include "CosmeticEventSubsystem.h"
+#include "Kismet/GameplayStatics.h"
+#include "ShootingCharacterMovementComponent.h"
+#include "VisibilityGridSubsystem.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Occluded Characters Culled"), STAT_OccludedCharactersCulled, STATGROUP_ShootingGame);
 
 //////////////////////////////////////////////////////////////////////////
 // AShootingGameCharacter
 
-AShootingGameCharacter::AShootingGameCharacter()
+AShootingGameCharacter::AShootingGameCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UShootingCharacterMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
+	// UCharacterTickSubsystem ticks all characters in one batch
+	PrimaryActorTick.bCanEverTick = false;
+
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
 
@@ -50,6 +66,8 @@ AShootingGameCharacter::AShootingGameCharacter()
 	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
 	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
 
+	Inventory = CreateDefaultSubobject<UWeaponInventoryComponent>(TEXT("Inventory"));
+
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named MyCharacter (to avoid direct content references in C++)
 
@@ -58,45 +76,338 @@ AShootingGameCharacter::AShootingGameCharacter()
 	AnimMontage = montage.Object;
 
 	IsRagdoll = false;
+	ReplicatedMovementTime = 0.0f;
+	StampedLocation = FVector::ZeroVector;
+	StampedRotation = FRotator::ZeroRotator;
+	StampedVelocity = FVector::ZeroVector;
+	StampedPitch = 0.0f;
+	MoveIntent = FVector2D::ZeroVector;
+	LookRateIntent = FVector2D::ZeroVector;
+
+	SpatialIndexHandle = INDEX_NONE;
+	BatchedTickHandle = INDEX_NONE;
+
+	ActiveNetUpdateFrequency = 60.0f;
+	IdleNetUpdateFrequency = 5.0f;
+	NetIdleDelay = 1.0f;
+	NetUpdateFrequency = ActiveNetUpdateFrequency;
+	LastNetActivityTime = 0.0f;
+	IsNetIdle = false;
+	RecentVictimHead = 0;
+	LastFireTime = -BIG_NUMBER;
+	TeamMask = AShootingPlayerState::ToTeamMask(AShootingPlayerState::NoTeam);
+
+	AttackerNetPriorityScale = 4.0f;
+	RecentAttackTime = 3.0f;
+	InViewNetPriorityScale = 2.0f;
+	ViewConeHalfAngle = 50.0f;
+	ThreatNetPriorityScale = 1.5f;
+	ThreatRadius = 2500.0f;
+	OccludedNetPriorityScale = 0.2f;
+	AudibleGunfireDistance = 5000.0f;
+	AudibleGunfireTime = 2.0f;
+	JoinNetPriorityTime = 10.0f;
+	JoinOwnPawnNetPriorityScale = 4.0f;
+
+	WeaponSocketName = TEXT("WeaponSocket");
+	HitImpactEffect = nullptr;
 }
 
 void AShootingGameCharacter::BeginPlay()
 {
 	Super::BeginPlay();
 
-	BindPlayerState();
+	if (GetPlayerState())
+	{
+		BindPlayerState();
+	}
+
+	SpatialIndexHandle = GetWorld()->GetSubsystem<UCharacterSpatialIndex>()->Add(this, GetActorLocation());
+	BatchedTickHandle = GetWorld()->GetSubsystem<UCharacterTickSubsystem>()->Register(this);
+}
+
+void AShootingGameCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (SpatialIndexHandle != INDEX_NONE)
+	{
+		GetWorld()->GetSubsystem<UCharacterSpatialIndex>()->Remove(SpatialIndexHandle);
+		SpatialIndexHandle = INDEX_NONE;
+	}
+
+	if (BatchedTickHandle != INDEX_NONE)
+	{
+		GetWorld()->GetSubsystem<UCharacterTickSubsystem>()->Unregister(BatchedTickHandle);
+		BatchedTickHandle = INDEX_NONE;
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
-void AShootingGameCharacter::Tick(float DeltaTime)
+void AShootingGameCharacter::SampleBatchedTick(FCharacterTickSample& Out, float Now) const
 {
-	Super::Tick(DeltaTime);
+	// Plain member reads only: no virtuals, and nothing owned by the controller
+	Out.Location = GetActorLocation();
+	Out.IsMoving = GetCharacterMovement()->Velocity.SizeSquared() > 1.0f;
+	Out.IsNetIdleDue = IsNetIdle == false && Now - LastNetActivityTime >= NetIdleDelay;
+}
 
+float AShootingGameCharacter::GetControlPitch() const
+{
+	const UShootingCharacterMovementComponent* Movement = Cast<UShootingCharacterMovementComponent>(GetCharacterMovement());
+	if (GetLocalRole() == ROLE_SimulatedProxy && Movement && Movement->HasInterpolatedPitch())
+		return Movement->GetInterpolatedPitch();
+
+	return ControlPitch;
+}
+
+void AShootingGameCharacter::CommitBatchedTick(const FCharacterTickSample& Sample)
+{
 	if (HasAuthority() == true)
 	{
-		ControlPitch = GetControlRotation().Pitch;
+		// GetControlRotation is virtual and reads the controller, so aim is read here rather than in the sample
+		const float NewControlPitch = Controller ? Controller->GetControlRotation().Pitch : ControlPitch;
+
+		// Aiming in place changes nothing but the pitch, and still has to reach clients at the active rate
+		const bool IsAiming = NewControlPitch != ControlPitch;
+		if (IsAiming)
+		{
+			ControlPitch = NewControlPitch;
+			MARK_PROPERTY_DIRTY_FROM_NAME(AShootingGameCharacter, ControlPitch, this);
+		}
+
+		UpdateNetActivity(Sample.IsMoving || IsAiming, Sample.IsNetIdleDue);
+	}
+
+	if (SpatialIndexHandle != INDEX_NONE)
+	{
+		GetWorld()->GetSubsystem<UCharacterSpatialIndex>()->Update(SpatialIndexHandle, Sample.Location);
 	}
 }
 
 float AShootingGameCharacter::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
 {
-	GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Yellow, 
-		FString::Printf(TEXT("TakeDamage Damage=%f EventInstigator=%s"), DamageAmount, *EventInstigator->GetName()));
+	// Catches damage from anything that did not filter by team itself
+	if (CanBeDamagedBy(EventInstigator, AShootingPlayerState::GetDamageMask(EventInstigator)) == false)
+		return 0.0f;
+
+	SHOOTING_DEBUG_MESSAGE(TEXT("TakeDamage Damage=%f EventInstigator=%s"), DamageAmount, *GetNameSafe(EventInstigator));
 
 	AShootingPlayerState* ps = Cast<AShootingPlayerState>(GetPlayerState());
 	if (ps)
 	{
+		bool WasAlive = ps->GetCurHp() > 0;
+
+		AShootingGameCharacter* Attacker = EventInstigator ? Cast<AShootingGameCharacter>(EventInstigator->GetPawn()) : nullptr;
+		if (Attacker && Attacker != this)
+		{
+			Attacker->NoteDamagedController(GetController());
+		}
+
 		ps->AddDamage(DamageAmount);
+
+		if (WasAlive && ps->GetCurHp() <= 0)
+		{
+			AShootingGameGameMode* gm = GetWorld()->GetAuthGameMode<AShootingGameGameMode>();
+			if (gm)
+			{
+				gm->OnCharacterDied(this);
+			}
+		}
 	}
 
 	return 0.0f;
 }
 
+void AShootingGameCharacter::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+
+	BindPlayerState();
+	RefreshTeam();
+
+	if (IsValid(EquipWeapon))
+	{
+		SetOwnerWeapon();
+	}
+	else if (Inventory->HasWeapons())
+	{
+		Inventory->EquipSlot(0);
+	}
+	else if (DefaultWeaponClass)
+	{
+		SetEquipWeapon(SpawnWeapon(DefaultWeaponClass));
+	}
+}
+
+void AShootingGameCharacter::UnPossessed()
+{
+	AShootingPlayerState* ps = Cast<AShootingPlayerState>(GetPlayerState());
+	if (IsValid(ps))
+	{
+		ps->Fuc_Dele_UpdateHp_TwoParams.RemoveAll(this);
+	}
+
+	Super::UnPossessed();
+
+	RefreshTeam();
+}
+
+void AShootingGameCharacter::RefreshTeam()
+{
+	AShootingPlayerState* ps = Cast<AShootingPlayerState>(GetPlayerState());
+	TeamMask = ps ? ps->GetTeamMask() : AShootingPlayerState::ToTeamMask(AShootingPlayerState::NoTeam);
+}
+
+bool AShootingGameCharacter::IsTeammateOf(const AActor* Viewer) const
+{
+	const AController* Controller = Cast<AController>(Viewer);
+	const AShootingPlayerState* ps = Controller ? Controller->GetPlayerState<AShootingPlayerState>() : nullptr;
+	return ps && ps->GetTeamId() != AShootingPlayerState::NoTeam && ps->GetTeamMask() == TeamMask;
+}
+
+void AShootingGameCharacter::OnRep_PlayerState()
+{
+	Super::OnRep_PlayerState();
+
+	BindPlayerState();
+}
+
+void AShootingGameCharacter::OnRep_Controller()
+{
+	Super::OnRep_Controller();
+
+	OnRep_EquipWeapon();
+}
+
+float AShootingGameCharacter::GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth)
+{
+	float Priority = Super::GetNetPriority(ViewPos, ViewDir, Viewer, ViewTarget, InChannel, Time, bLowBandwidth);
+
+	if (Viewer == nullptr)
+		return Priority;
+
+	// The viewer's own pawn first, so a joining client can play before the rest of the match streams in
+	if (Viewer == GetController())
+		return Viewer->GetGameTimeSinceCreation() < JoinNetPriorityTime ? Priority * JoinOwnPawnNetPriorityScale : Priority;
+
+	const FVector ToCharacter = GetActorLocation() - ViewPos;
+	const float DistSq = ToCharacter.SizeSquared();
+
+	// Whoever is shooting at the viewer matters most under bandwidth pressure
+	if (IsRecentVictim(Viewer))
+	{
+		Priority *= AttackerNetPriorityScale;
+	}
+	else if (IsTeammateOf(Viewer) == false && IsPotentiallyVisibleTo(Viewer, ViewPos) == false)
+	{
+		Priority *= OccludedNetPriorityScale;
+	}
+
+	if ((ToCharacter | ViewDir) > FMath::Cos(FMath::DegreesToRadians(ViewConeHalfAngle)) * FMath::Sqrt(DistSq))
+	{
+		Priority *= InViewNetPriorityScale;
+	}
+
+	if (DistSq < FMath::Square(ThreatRadius))
+	{
+		Priority *= ThreatNetPriorityScale;
+	}
+
+	return Priority;
+}
+
+bool AShootingGameCharacter::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	// Past the net cull distance teammates are dropped like anyone else; AShootingTeamInfo already carries their positions
+	if (Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation) == false)
+		return false;
+
+	// Within it, teammates are kept through walls
+	if (ViewTarget == this || RealViewer == GetController() || bAlwaysRelevant || IsTeammateOf(RealViewer))
+		return true;
+
+	if (IsPotentiallyVisibleTo(RealViewer, SrcLocation))
+		return true;
+
+	INC_DWORD_STAT(STAT_OccludedCharactersCulled);
+	return false;
+}
+
+bool AShootingGameCharacter::IsRecentVictim(const AActor* Viewer) const
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	for (const FRecentVictim& Victim : RecentVictims)
+	{
+		if (Victim.Controller.Get() == Viewer && Now - Victim.Time < RecentAttackTime)
+			return true;
+	}
+	return false;
+}
+
+bool AShootingGameCharacter::IsPotentiallyVisibleTo(const AActor* Viewer, const FVector& ViewPos) const
+{
+	const FVector Location = GetActorLocation();
+	if (GetWorld()->GetSubsystem<UVisibilityGridSubsystem>()->IsPotentiallyVisible(ViewPos, Location))
+		return true;
+
+	// Gunfire carries through walls, and a hidden shooter still has to exist for its victim
+	if (GetWorld()->GetTimeSeconds() - LastFireTime < AudibleGunfireTime && FVector::DistSquared(ViewPos, Location) < FMath::Square(AudibleGunfireDistance))
+		return true;
+
+	return IsRecentVictim(Viewer);
+}
+
+void AShootingGameCharacter::NoteDamagedController(AController* Victim)
+{
+	for (FRecentVictim& Entry : RecentVictims)
+	{
+		if (Entry.Controller.Get() == Victim)
+		{
+			Entry.Time = GetWorld()->GetTimeSeconds();
+			return;
+		}
+	}
+
+	RecentVictims[RecentVictimHead].Controller = Victim;
+	RecentVictims[RecentVictimHead].Time = GetWorld()->GetTimeSeconds();
+	RecentVictimHead = (RecentVictimHead + 1) % MaxRecentVictims;
+}
+
 void AShootingGameCharacter::GetLifetimeReplicatedProps(TArray< FLifetimeProperty >& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(AShootingGameCharacter, ControlPitch);
-	DOREPLIFETIME(AShootingGameCharacter, EquipWeapon);
+	FDoRepLifetimeParams PushParams;
+	PushParams.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShootingGameCharacter, ControlPitch, PushParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShootingGameCharacter, EquipWeapon, PushParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShootingGameCharacter, IsRagdoll, PushParams);
+
+	FDoRepLifetimeParams SimulatedPushParams;
+	SimulatedPushParams.bIsPushBased = true;
+	SimulatedPushParams.Condition = COND_SimulatedOnly;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShootingGameCharacter, ReplicatedMovementTime, SimulatedPushParams);
+}
+
+void AShootingGameCharacter::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	// Only a changed state gets a new stamp, so a still character sends nothing extra. Aim counts, or proxies would hold a stale pitch.
+	const FRepMovement& Movement = GetReplicatedMovement();
+	if (ReplicatedMovementTime == 0.0f || Movement.Location != StampedLocation || Movement.Rotation != StampedRotation || Movement.LinearVelocity != StampedVelocity
+		|| ControlPitch != StampedPitch)
+	{
+		StampedLocation = Movement.Location;
+		StampedRotation = Movement.Rotation;
+		StampedVelocity = Movement.LinearVelocity;
+		StampedPitch = ControlPitch;
+
+		ReplicatedMovementTime = GetWorld()->GetTimeSeconds();
+		MARK_PROPERTY_DIRTY_FROM_NAME(AShootingGameCharacter, ReplicatedMovementTime, this);
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -135,16 +446,57 @@ void AShootingGameCharacter::SetupPlayerInputComponent(class UInputComponent* Pl
 
 	// Reload
 	PlayerInputComponent->BindAction("Reload", IE_Pressed, this, &AShootingGameCharacter::PressReload);
+
+	// Weapon swap
+	PlayerInputComponent->BindAction("NextWeapon", IE_Pressed, this, &AShootingGameCharacter::PressNextWeapon);
 }
 
 AActor* AShootingGameCharacter::SetEquipWeapon(AActor* Weapon)
 {
 	EquipWeapon = Weapon;
-	TestSetOwnerWeapon();
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShootingGameCharacter, EquipWeapon, this);
+
+	if (HasAuthority())
+	{
+		NoteNetActivity();
+	}
+
+	if (IsValid(EquipWeapon) && IsValid(GetController()))
+	{
+		SetOwnerWeapon();
+	}
 
 	return EquipWeapon;
 }
 
+AWeapon* AShootingGameCharacter::SpawnWeapon(TSubclassOf<AWeapon> WeaponClass)
+{
+	if (HasAuthority() == false || WeaponClass == nullptr)
+		return nullptr;
+
+	AWeapon* weapon = GetWorld()->SpawnActorDeferred<AWeapon>(WeaponClass, GetActorTransform(), GetController(), this,
+		ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	if (weapon == nullptr)
+		return nullptr;
+
+	weapon->SetOwnChar(this);
+	weapon->FinishSpawning(GetActorTransform());
+
+	// AWeapon replicates movement, so the attachment reaches clients together with OwnChar
+	weapon->AttachToComponent(GetMesh(), FAttachmentTransformRules::SnapToTargetNotIncludingScale, WeaponSocketName);
+
+	return weapon;
+}
+
+void AShootingGameCharacter::OnRep_EquipWeapon()
+{
+	AWeapon* weapon = Cast<AWeapon>(EquipWeapon);
+	if (weapon)
+	{
+		weapon->UpdateAmmoToHud();
+	}
+}
+
 void AShootingGameCharacter::OnNotifyShoot()
 {
 	IWeaponInterface* InterfaceObj = Cast<IWeaponInterface>(EquipWeapon);
@@ -157,8 +509,7 @@ void AShootingGameCharacter::OnNotifyShoot()
 
 void AShootingGameCharacter::OnUpdateHp_Implementation(float CurrentHp, float MaxHp)
 {
-	GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Yellow,
-		FString::Printf(TEXT("OnUpdateHp CurrentHp : %f"), CurrentHp));
+	SHOOTING_DEBUG_MESSAGE(TEXT("OnUpdateHp CurrentHp : %f"), CurrentHp);
 
 	if (CurrentHp <= 0)
 	{
@@ -169,6 +520,7 @@ void AShootingGameCharacter::OnUpdateHp_Implementation(float CurrentHp, float Ma
 void AShootingGameCharacter::DoRagdoll()
 {
 	IsRagdoll = true;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShootingGameCharacter, IsRagdoll, this);
 
 	GetMesh()->SetSimulatePhysics(true);
 }
@@ -176,6 +528,7 @@ void AShootingGameCharacter::DoRagdoll()
 void AShootingGameCharacter::DoGetup()
 {
 	IsRagdoll = false;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShootingGameCharacter, IsRagdoll, this);
 
 	GetMesh()->SetSimulatePhysics(false);
 
@@ -186,8 +539,143 @@ void AShootingGameCharacter::DoGetup()
 	GetMesh()->SetRelativeLocationAndRotation(loc, Rot);
 }
 
+void AShootingGameCharacter::DeactivateToPool()
+{
+	// Wake up so the hidden state reaches clients and closes the channel
+	SetNetDormancy(DORM_Awake);
+
+	GetWorldTimerManager().ClearAllTimersForObject(this);
+
+	GetCharacterMovement()->StopMovementImmediately();
+	GetCharacterMovement()->SetComponentTickEnabled(false);
+	MoveIntent = FVector2D::ZeroVector;
+	LookRateIntent = FVector2D::ZeroVector;
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+
+	if (BatchedTickHandle != INDEX_NONE)
+	{
+		GetWorld()->GetSubsystem<UCharacterTickSubsystem>()->Unregister(BatchedTickHandle);
+		BatchedTickHandle = INDEX_NONE;
+	}
+
+	if (IsValid(EquipWeapon))
+	{
+		EquipWeapon->FlushNetDormancy();
+		EquipWeapon->SetActorHiddenInGame(true);
+	}
+
+	if (SpatialIndexHandle != INDEX_NONE)
+	{
+		GetWorld()->GetSubsystem<UCharacterSpatialIndex>()->Remove(SpatialIndexHandle);
+		SpatialIndexHandle = INDEX_NONE;
+	}
+}
+
+void AShootingGameCharacter::ActivateFromPool(const FTransform& SpawnTransform)
+{
+	if (IsRagdoll)
+	{
+		DoGetup();
+	}
+
+	SetActorLocationAndRotation(SpawnTransform.GetLocation(), SpawnTransform.GetRotation(), false, nullptr, ETeleportType::ResetPhysics);
+
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SetActorTickEnabled(true);
+
+	if (BatchedTickHandle == INDEX_NONE)
+	{
+		BatchedTickHandle = GetWorld()->GetSubsystem<UCharacterTickSubsystem>()->Register(this);
+	}
+
+	GetCharacterMovement()->SetComponentTickEnabled(true);
+	GetCharacterMovement()->SetMovementMode(MOVE_Walking);
+
+	if (SpatialIndexHandle == INDEX_NONE)
+	{
+		SpatialIndexHandle = GetWorld()->GetSubsystem<UCharacterSpatialIndex>()->Add(this, GetActorLocation());
+	}
+
+	Inventory->ResetAmmo();
+
+	AWeapon* weapon = Cast<AWeapon>(EquipWeapon);
+	if (weapon)
+	{
+		weapon->SetActorHiddenInGame(false);
+		weapon->ResetAmmo();
+	}
+
+	NoteNetActivity();
+}
+
+void AShootingGameCharacter::NoteNetActivity()
+{
+	LastNetActivityTime = GetWorld()->GetTimeSeconds();
+
+	// GoNetDormant put the character itself to sleep, not only its weapon
+	if (NetDormancy != DORM_Awake)
+	{
+		SetNetDormancy(DORM_Awake);
+	}
+
+	if (IsNetIdle == false)
+		return;
+
+	IsNetIdle = false;
+	NetUpdateFrequency = ActiveNetUpdateFrequency;
+	ForceNetUpdate();
+
+	if (IsValid(EquipWeapon))
+	{
+		EquipWeapon->SetNetDormancy(DORM_Awake);
+	}
+}
+
+void AShootingGameCharacter::GoNetDormant()
+{
+	IsNetIdle = true;
+	NetUpdateFrequency = IdleNetUpdateFrequency;
+
+	SetNetDormancy(DORM_DormantAll);
+
+	if (IsValid(EquipWeapon))
+	{
+		EquipWeapon->SetNetDormancy(DORM_DormantAll);
+	}
+}
+
+void AShootingGameCharacter::UpdateNetActivity(bool IsActive, bool IsIdleDue)
+{
+	if (NetDormancy != DORM_Awake)
+		return;
+
+	if (IsActive)
+	{
+		NoteNetActivity();
+		return;
+	}
+
+	if (IsIdleDue == false)
+		return;
+
+	// Idle: the character itself keeps a slow heartbeat, its weapon has nothing to send until the next fire, reload or equip
+	IsNetIdle = true;
+	NetUpdateFrequency = IdleNetUpdateFrequency;
+
+	if (IsValid(EquipWeapon))
+	{
+		EquipWeapon->SetNetDormancy(DORM_DormantAll);
+	}
+}
+
 void AShootingGameCharacter::ReqPressTrigger_Implementation()
 {
+	NoteNetActivity();
+
 	IWeaponInterface* InterfaceObj = Cast<IWeaponInterface>(EquipWeapon);
 
 	if (InterfaceObj)
@@ -198,10 +686,23 @@ void AShootingGameCharacter::ReqPressTrigger_Implementation()
 			return;
 	}
 
-	ResPressTrigger();
+	PlayPressTrigger();
+	LastFireTime = GetWorld()->GetTimeSeconds();
+
+	if (IsPlayerControlled() && IsLocallyControlled() == false)
+	{
+		ResPressTrigger();
+	}
+
+	GetWorld()->GetSubsystem<UCosmeticEventSubsystem>()->QueueEvent(ECosmeticEventType::Fire, this, GetActorLocation());
 }
 
 void AShootingGameCharacter::ResPressTrigger_Implementation()
+{
+	PlayPressTrigger();
+}
+
+void AShootingGameCharacter::PlayPressTrigger()
 {
 	IWeaponInterface* InterfaceObj = Cast<IWeaponInterface>(EquipWeapon);
 
@@ -213,26 +714,49 @@ void AShootingGameCharacter::ResPressTrigger_Implementation()
 
 void AShootingGameCharacter::ReqPressC_Implementation()
 {
-	ResPressC();
+	// IsRagdoll replicates, so late joiners and clients that missed the toggle still end up in the right pose
+	if (IsRagdoll)
+	{
+		DoGetup();
+	}
+	else
+	{
+		DoRagdoll();
+	}
 }
 
-void AShootingGameCharacter::ResPressC_Implementation()
+void AShootingGameCharacter::OnRep_IsRagdoll()
 {
 	if (IsRagdoll)
 	{
-		DoGetup();
+		DoRagdoll();
 	}
 	else
 	{
-		DoRagdoll();
+		DoGetup();
 	}
 }
 
 void AShootingGameCharacter::ReqPressReload_Implementation()
 {
-	ResPressReload();
+	NoteNetActivity();
+
+	PlayPressReload();
+
+	if (IsPlayerControlled() && IsLocallyControlled() == false)
+	{
+		ResPressReload();
+	}
+
+	GetWorld()->GetSubsystem<UCosmeticEventSubsystem>()->QueueEvent(ECosmeticEventType::Reload, this, GetActorLocation());
 }
+
 void AShootingGameCharacter::ResPressReload_Implementation()
+{
+	PlayPressReload();
+}
+
+void AShootingGameCharacter::PlayPressReload()
 {
 	IWeaponInterface* InterfaceObj = Cast<IWeaponInterface>(EquipWeapon);
 
@@ -242,6 +766,11 @@ void AShootingGameCharacter::ResPressReload_Implementation()
 	}
 }
 
+void AShootingGameCharacter::PlayHitImpact(const FVector& Location, const FVector& Normal)
+{
+	UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), HitImpactEffect, Location, Normal.Rotation(), FVector(1.0f), true, EPSCPoolMethod::AutoRelease);
+}
+
 void AShootingGameCharacter::OnResetVR()
 {
 	// If ShootingGame is added to a project via 'Add Feature' in the Unreal Editor the dependency on HeadMountedDisplay in ShootingGame.Build.cs is not automatically propagated
@@ -265,6 +794,14 @@ void AShootingGameCharacter::TouchStopped(ETouchIndex::Type FingerIndex, FVector
 
 void AShootingGameCharacter::PressTrigger()
 {
+	// Remote clients send the press with their next move instead of a separate RPC
+	UShootingCharacterMovementComponent* Movement = Cast<UShootingCharacterMovementComponent>(GetCharacterMovement());
+	if (HasAuthority() == false && Movement && Movement->IsComponentTickEnabled())
+	{
+		Movement->bPressedFire = true;
+		return;
+	}
+
 	ReqPressTrigger();
 }
 
@@ -275,83 +812,87 @@ void AShootingGameCharacter::PressTestKey()
 	ReqPressC();
 }
 
-void AShootingGameCharacter::TestSetOwnerWeapon()
+void AShootingGameCharacter::SetOwnerWeapon()
 {
-	if (IsValid(GetController()))
-	{
-		GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Yellow, 
-			FString::Printf(TEXT("SetOwnerComplate!!! Owner : %s"), *GetController()->GetName()));
+	EquipWeapon->SetOwner(GetController());
 
-		EquipWeapon->SetOwner(GetController());
-		AWeapon* weapon = Cast<AWeapon>(EquipWeapon);
-		if (weapon)
-		{
-			weapon->OwnChar = this;
-			weapon->UpdateAmmoToHud();
-		}
-		return;
+	AWeapon* weapon = Cast<AWeapon>(EquipWeapon);
+	if (weapon)
+	{
+		weapon->SetOwnChar(this);
+		weapon->UpdateAmmoToHud();
 	}
-
-	FTimerManager& timerManager = GetWorld()->GetTimerManager();
-	timerManager.SetTimer(th_SetOwnerWeapon, this, &AShootingGameCharacter::TestSetOwnerWeapon, 0.1f, false);
 }
 
 void AShootingGameCharacter::BindPlayerState()
 {
+	// Called from BeginPlay, PossessedBy and OnRep_PlayerState, so pooled characters never poll for a player state
 	AShootingPlayerState* ps = Cast<AShootingPlayerState>(GetPlayerState());
 	if (IsValid(ps))
 	{
+		ps->Fuc_Dele_UpdateHp_TwoParams.RemoveAll(this);
 		ps->Fuc_Dele_UpdateHp_TwoParams.AddUFunction(this, FName("OnUpdateHp"));
 		OnUpdateHp(ps->GetCurHp(), ps->GetMaxHp());
-		return;
 	}
-
-	FTimerManager& timerManager = GetWorld()->GetTimerManager();
-	timerManager.SetTimer(th_BindPlayerState, this, &AShootingGameCharacter::BindPlayerState, 0.1f, false);
 }
 
 void AShootingGameCharacter::PressReload()
 {
+	UShootingCharacterMovementComponent* Movement = Cast<UShootingCharacterMovementComponent>(GetCharacterMovement());
+	if (HasAuthority() == false && Movement && Movement->IsComponentTickEnabled())
+	{
+		Movement->bPressedReload = true;
+		return;
+	}
+
 	ReqPressReload();
 }
 
+void AShootingGameCharacter::PressNextWeapon()
+{
+	Inventory->EquipNext();
+}
+
 void AShootingGameCharacter::TurnAtRate(float Rate)
 {
-	// calculate delta for this frame from the rate information
-	AddControllerYawInput(Rate * BaseTurnRate * GetWorld()->GetDeltaSeconds());
+	LookRateIntent.X = Rate;
 }
 
 void AShootingGameCharacter::LookUpAtRate(float Rate)
 {
-	// calculate delta for this frame from the rate information
-	AddControllerPitchInput(Rate * BaseLookUpRate * GetWorld()->GetDeltaSeconds());
+	LookRateIntent.Y = Rate;
 }
 
 void AShootingGameCharacter::MoveForward(float Value)
 {
-	if ((Controller != nullptr) && (Value != 0.0f))
-	{
-		// find out which way is forward
-		const FRotator Rotation = Controller->GetControlRotation();
-		const FRotator YawRotation(0, Rotation.Yaw, 0);
-
-		// get forward vector
-		const FVector Direction = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::X);
-		AddMovementInput(Direction, Value);
-	}
+	MoveIntent.X = Value;
 }
 
 void AShootingGameCharacter::MoveRight(float Value)
 {
-	if ( (Controller != nullptr) && (Value != 0.0f) )
+	MoveIntent.Y = Value;
+}
+
+void AShootingGameCharacter::ApplyInputIntent(float DeltaTime)
+{
+	if (Controller == nullptr)
+		return;
+
+	if (LookRateIntent.IsZero() == false)
 	{
-		// find out which way is right
-		const FRotator Rotation = Controller->GetControlRotation();
-		const FRotator YawRotation(0, Rotation.Yaw, 0);
-	
-		// get right vector 
-		const FVector Direction = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::Y);
-		// add movement in that direction
-		AddMovementInput(Direction, Value);
+		// calculate delta for this frame from the rate information
+		AddControllerYawInput(LookRateIntent.X * BaseTurnRate * DeltaTime);
+		AddControllerPitchInput(LookRateIntent.Y * BaseLookUpRate * DeltaTime);
+	}
+
+	if (MoveIntent.IsZero() == false)
+	{
+		// One yaw basis for both axes instead of a rotation matrix per axis
+		float Sin, Cos;
+		FMath::SinCos(&Sin, &Cos, FMath::DegreesToRadians(Controller->GetControlRotation().Yaw));
+
+		const FVector Forward(Cos, Sin, 0.0f);
+		const FVector Right(-Sin, Cos, 0.0f);
+		AddMovementInput(Forward * MoveIntent.X + Right * MoveIntent.Y);
 	}
 }
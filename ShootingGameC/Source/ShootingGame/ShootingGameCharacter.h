@@ -18,18 +18,37 @@ class AShootingGameCharacter : public ACharacter
 	/** Follow camera */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class UCameraComponent* FollowCamera;
+
+	/** Carried weapons, of which only the equipped one is spawned as an actor */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Weapon, meta = (AllowPrivateAccess = "true"))
+	class UWeaponInventoryComponent* Inventory;
 public:
-	AShootingGameCharacter();
+	AShootingGameCharacter(const FObjectInitializer& ObjectInitializer);
 
 public:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser) override;
 
+	virtual void PossessedBy(AController* NewController) override;
+
+	virtual void UnPossessed() override;
+
+	virtual void OnRep_PlayerState() override;
+
+	virtual void OnRep_Controller() override;
+
+	virtual float GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth) override;
+
+	/** Stamps each new replicated movement state with the server time */
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+
+	/** Teammates within the net cull distance stay relevant through walls. Enemies the map's visibility grid hides from the viewer are dropped, unless they can be heard or are shooting at it. */
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
 	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Camera)
 	float BaseTurnRate;
@@ -43,21 +62,27 @@ public:
 	UFUNCTION(Server, Reliable)
 	void ReqPressTrigger();
 
-	UFUNCTION(NetMulticast, Reliable)
+	/** Owning client only: its shoot notify sends the shot, so its fire stays reliable. Others get a cosmetic event. */
+	UFUNCTION(Client, Reliable)
 	void ResPressTrigger();
 
 	UFUNCTION(Server, Reliable)
 	void ReqPressC();
 
-	UFUNCTION(NetMulticast, Reliable)
-	void ResPressC();
-
 	UFUNCTION(Server, Reliable)
 	void ReqPressReload();
 
-	UFUNCTION(NetMulticast, Reliable)
+	UFUNCTION(Client, Reliable)
 	void ResPressReload();
 
+	/** Plays the fire montage on this machine */
+	void PlayPressTrigger();
+
+	/** Plays the reload montage on this machine */
+	void PlayPressReload();
+
+	void PlayHitImpact(const FVector& Location, const FVector& Normal);
+
 protected:
 
 	/** Resets HMD orientation in VR. */
@@ -91,12 +116,14 @@ protected:
 
 	void PressTestKey();
 
-	void TestSetOwnerWeapon();
+	void SetOwnerWeapon();
 
 	void BindPlayerState();
 
 	void PressReload();
 
+	void PressNextWeapon();
+
 protected:
 	// APawn interface
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
@@ -107,13 +134,28 @@ public:
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
 	/** Returns FollowCamera subobject **/
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
+	/** Returns Inventory subobject **/
+	FORCEINLINE class UWeaponInventoryComponent* GetInventory() const { return Inventory; }
 
 	UFUNCTION(BlueprintPure)
-	FORCEINLINE float GetControlPitch() const { return ControlPitch; }
+	FORCEINLINE AActor* GetEquipWeapon() const { return EquipWeapon; }
+
+	/** Aim pitch for the anim blueprint, taken from the snapshot interpolation on simulated proxies */
+	UFUNCTION(BlueprintPure)
+	float GetControlPitch() const;
+
+	/** Last replicated aim pitch, 0-360 */
+	FORCEINLINE float GetReplicatedControlPitch() const { return ControlPitch; }
+
+	/** Server world time of the last replicated movement, whoever controls the character */
+	FORCEINLINE float GetReplicatedMovementTime() const { return ReplicatedMovementTime; }
 
 	UFUNCTION(BlueprintCallable)
 	AActor* SetEquipWeapon(AActor* Weapon);
 
+	/** Spawns a weapon on the server with owner, instigator and OwnChar already set, attached to WeaponSocketName. */
+	class AWeapon* SpawnWeapon(TSubclassOf<class AWeapon> WeaponClass);
+
 	UFUNCTION(BlueprintCallable)
 	void OnNotifyShoot();
 
@@ -128,20 +170,182 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void DoGetup();
 
+	UFUNCTION()
+	void OnRep_EquipWeapon();
+
+	UFUNCTION()
+	void OnRep_IsRagdoll();
+
+	/** Hides and freezes the character so the game mode can keep it for a later respawn. */
+	void DeactivateToPool();
+
+	/** Moves a pooled character to the spawn point and restores hp, ammo and pose. */
+	void ActivateFromPool(const FTransform& SpawnTransform);
+
+	/** Server: movement, fire, reload or equip happened, so replicate the character and its weapon at the active rate */
+	void NoteNetActivity();
+
+	/** Server: stops replicating a dead character and its weapon until it is respawned */
+	void GoNetDormant();
+
+	/** Server: remembers that this character just damaged Victim, so Victim's connection prioritizes it */
+	void NoteDamagedController(AController* Victim);
+
+	/** Read only, may run on a worker thread. Now is the world time of this batch. */
+	void SampleBatchedTick(struct FCharacterTickSample& Out, float Now) const;
+
+	/** Game thread: applies what SampleBatchedTick gathered this frame */
+	void CommitBatchedTick(const struct FCharacterTickSample& Sample);
+
+	FORCEINLINE void SetBatchedTickHandle(int32 Handle) { BatchedTickHandle = Handle; }
+
+	/** Movement intent in control space, X forward and Y right. Bots set it directly; players get it from the axis bindings. */
+	FORCEINLINE void SetMoveIntent(const FVector2D& Intent) { MoveIntent = Intent; }
+
+	/** Feeds this frame's move and look intent to the controller and movement component in one step. Called by the movement component before it moves. */
+	void ApplyInputIntent(float DeltaTime);
+
+	/** Server: team bit of the controlling player, cached so damage and relevancy checks skip the player state */
+	FORCEINLINE uint32 GetTeamMask() const { return TeamMask; }
+
+	/** Server: rereads the team from the player state */
+	void RefreshTeam();
+
+	/** Server: friendly-fire filter. DamageMask comes from AShootingPlayerState::GetDamageMask of the instigator; self damage always applies. */
+	FORCEINLINE bool CanBeDamagedBy(const AController* EventInstigator, uint32 DamageMask) const
+	{
+		return (DamageMask & TeamMask) != 0 || (EventInstigator && EventInstigator == GetController());
+	}
+
 private:
-	UPROPERTY(Replicated)
+	UPROPERTY(ReplicatedUsing = OnRep_EquipWeapon)
 	AActor* EquipWeapon;
 
 	UPROPERTY(Replicated)
 	float ControlPitch;
 
+	/** Arrives with ReplicatedMovement, so simulated proxies can interpolate it in the server's time base */
+	UPROPERTY(Replicated)
+	float ReplicatedMovementTime;
+
+	/** Movement and aim that ReplicatedMovementTime was stamped for */
+	FVector StampedLocation;
+
+	FRotator StampedRotation;
+
+	FVector StampedVelocity;
+
+	float StampedPitch;
+
+	UPROPERTY(ReplicatedUsing = OnRep_IsRagdoll)
 	bool IsRagdoll;
 
-	FTimerHandle th_SetOwnerWeapon;
+	FVector2D MoveIntent;
+
+	/** Turn and look up rates, X turn and Y look up */
+	FVector2D LookRateIntent;
+
+	/** Entry in UCharacterSpatialIndex, INDEX_NONE while pooled */
+	int32 SpatialIndexHandle;
+
+	/** Entry in UCharacterTickSubsystem, INDEX_NONE while pooled */
+	int32 BatchedTickHandle;
+
+	/** IsActive: moving or aiming this frame. IsIdleDue: NetIdleDelay has passed since the last activity. */
+	void UpdateNetActivity(bool IsActive, bool IsIdleDue);
+
+	float LastNetActivityTime;
+
+	bool IsNetIdle;
+
+	struct FRecentVictim
+	{
+		TWeakObjectPtr<AController> Controller;
+		float Time = -BIG_NUMBER;
+	};
+
+	static const int32 MaxRecentVictims = 4;
+
+	FRecentVictim RecentVictims[MaxRecentVictims];
+
+	int32 RecentVictimHead;
+
+	bool IsRecentVictim(const AActor* Viewer) const;
+
+	/** Server: whether a viewer at ViewPos might see or hear this character */
+	bool IsPotentiallyVisibleTo(const AActor* Viewer, const FVector& ViewPos) const;
+
+	/** Server world time of the last shot, for the audible gunfire fallback */
+	float LastFireTime;
+
+	bool IsTeammateOf(const AActor* Viewer) const;
 
-	FTimerHandle th_BindPlayerState;
+	uint32 TeamMask;
 
 public:
+	/** Net update frequency while the character moves or uses its weapon */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replication)
+	float ActiveNetUpdateFrequency;
+
+	/** Net update frequency once the character has been still for NetIdleDelay */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replication)
+	float IdleNetUpdateFrequency;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replication)
+	float NetIdleDelay;
+
+	/** Priority multiplier toward a viewer this character damaged within RecentAttackTime */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replication)
+	float AttackerNetPriorityScale;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replication)
+	float RecentAttackTime;
+
+	/** Priority multiplier while inside the viewer's view cone */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replication)
+	float InViewNetPriorityScale;
+
+	/** Half angle of the view cone, in degrees */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replication)
+	float ViewConeHalfAngle;
+
+	/** Priority multiplier while within ThreatRadius of the viewer */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replication)
+	float ThreatNetPriorityScale;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replication)
+	float ThreatRadius;
+
+	/** Priority multiplier while hidden from the viewer but not yet closed by the relevancy timeout */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replication)
+	float OccludedNetPriorityScale;
+
+	/** A character that fired within AudibleGunfireTime stays relevant to viewers within AudibleGunfireDistance, walls or not */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replication)
+	float AudibleGunfireDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replication)
+	float AudibleGunfireTime;
+
+	/** Seconds after a client's controller spawns during which its own pawn goes out ahead of the rest of the match */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replication)
+	float JoinNetPriorityTime;
+
+	/** Priority multiplier toward the owning client while it is joining */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replication)
+	float JoinOwnPawnNetPriorityScale;
+
+	/** Weapon spawned and equipped by the server when the character is first possessed */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	TSubclassOf<class AWeapon> DefaultWeaponClass;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Weapon)
+	FName WeaponSocketName;
+
+	/** Played where a hitscan shot hits this character */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Effects)
+	class UParticleSystem* HitImpactEffect;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	TSubclassOf<UUserWidget> NameTagWidgetClass;
 
@@ -1,9 +1,19 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "ShootingGameGameMode.h"
+#include "ShootingGame.h"
 #include "ShootingGameCharacter.h"
+#include "ShootingPlayerState.h"
+#include "ShootingTeamInfo.h"
+#include "TimerManager.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
 #include "UObject/ConstructorHelpers.h"
 
+DECLARE_CYCLE_STAT(TEXT("Respawn"), STAT_Respawn, STATGROUP_ShootingGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pawn Pool Misses"), STAT_PawnPoolMiss, STATGROUP_ShootingGame);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Pawns"), STAT_PooledPawns, STATGROUP_ShootingGame);
+
 AShootingGameGameMode::AShootingGameGameMode()
 {
 	// set default pawn class to our Blueprinted character
@@ -12,4 +22,196 @@ AShootingGameGameMode::AShootingGameGameMode()
 	{
 		DefaultPawnClass = PlayerPawnBPClass.Class;
 	}
+
+	PawnPoolSize = 8;
+	RespawnDelay = 5.0f;
+
+	MaxClientNetSpeed = 30000;
+
+	NumTeams = 2;
+	bFriendlyFire = false;
+	TeamInfoClass = AShootingTeamInfo::StaticClass();
+}
+
+void AShootingGameGameMode::BeginPlay()
+{
+	Super::BeginPlay();
+
+	ApplyClientNetSpeedCap();
+
+	if (DefaultPawnClass == nullptr || DefaultPawnClass->IsChildOf(AShootingGameCharacter::StaticClass()) == false)
+		return;
+
+	FActorSpawnParameters SpawnInfo;
+	SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnInfo.ObjectFlags |= RF_Transient;
+
+	for (int32 i = 0; i < PawnPoolSize; ++i)
+	{
+		AShootingGameCharacter* Char = GetWorld()->SpawnActor<AShootingGameCharacter>(DefaultPawnClass, FTransform::Identity, SpawnInfo);
+		if (Char)
+		{
+			ReleasePawn(Char);
+		}
+	}
+}
+
+void AShootingGameGameMode::PostLogin(APlayerController* NewPlayer)
+{
+	Super::PostLogin(NewPlayer);
+
+	// The driver may have started listening after BeginPlay, and this connection picked its speed before the cap applied
+	ApplyClientNetSpeedCap();
+
+	UNetConnection* Connection = NewPlayer->GetNetConnection();
+	if (Connection && MaxClientNetSpeed > 0)
+	{
+		Connection->CurrentNetSpeed = FMath::Min(Connection->CurrentNetSpeed, MaxClientNetSpeed);
+	}
+
+	AssignTeam(NewPlayer);
+}
+
+void AShootingGameGameMode::ApplyClientNetSpeedCap()
+{
+	UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (NetDriver == nullptr || MaxClientNetSpeed <= 0)
+		return;
+
+	// Every later netspeed request from a client is clamped to these by the engine, so the cap holds for the whole session
+	NetDriver->MaxClientRate = FMath::Min(NetDriver->MaxClientRate, MaxClientNetSpeed);
+	NetDriver->MaxInternetClientRate = FMath::Min(NetDriver->MaxInternetClientRate, MaxClientNetSpeed);
+}
+
+void AShootingGameGameMode::Logout(AController* Exiting)
+{
+	AShootingPlayerState* ps = Exiting ? Exiting->GetPlayerState<AShootingPlayerState>() : nullptr;
+	if (ps)
+	{
+		ps->SetTeam(AShootingPlayerState::NoTeam, nullptr, bFriendlyFire);
+	}
+
+	Super::Logout(Exiting);
+}
+
+void AShootingGameGameMode::AssignTeam(AController* Controller)
+{
+	AShootingPlayerState* ps = Controller ? Controller->GetPlayerState<AShootingPlayerState>() : nullptr;
+	const int32 TeamCount = FMath::Clamp(NumTeams, 0, 31);
+	if (ps == nullptr || TeamCount == 0)
+		return;
+
+	uint8 BestTeam = 0;
+	int32 BestCount = MAX_int32;
+	for (int32 i = 0; i < TeamCount; ++i)
+	{
+		AShootingTeamInfo* Team = GetOrSpawnTeamInfo(i);
+		const int32 Count = Team ? Team->GetNumMembers() : 0;
+		if (Count < BestCount)
+		{
+			BestTeam = (uint8)i;
+			BestCount = Count;
+		}
+	}
+
+	ps->SetTeam(BestTeam, GetOrSpawnTeamInfo(BestTeam), bFriendlyFire);
+}
+
+AShootingTeamInfo* AShootingGameGameMode::GetOrSpawnTeamInfo(uint8 TeamId)
+{
+	if (Teams.IsValidIndex(TeamId) && IsValid(Teams[TeamId]))
+		return Teams[TeamId];
+
+	if (TeamInfoClass == nullptr)
+		return nullptr;
+
+	FActorSpawnParameters SpawnInfo;
+	SpawnInfo.ObjectFlags |= RF_Transient;
+
+	AShootingTeamInfo* Team = GetWorld()->SpawnActor<AShootingTeamInfo>(TeamInfoClass, SpawnInfo);
+	if (Team)
+	{
+		Team->Init(TeamId);
+		if (Teams.Num() <= TeamId)
+		{
+			Teams.SetNum(TeamId + 1);
+		}
+		Teams[TeamId] = Team;
+	}
+	return Team;
+}
+
+APawn* AShootingGameGameMode::SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform)
+{
+	UClass* PawnClass = GetDefaultPawnClassForController(NewPlayer);
+
+	while (PawnPool.Num() > 0)
+	{
+		AShootingGameCharacter* Char = PawnPool.Pop(false);
+		DEC_DWORD_STAT(STAT_PooledPawns);
+
+		if (IsValid(Char) && Char->GetClass() == PawnClass)
+		{
+			Char->ActivateFromPool(SpawnTransform);
+			return Char;
+		}
+	}
+
+	INC_DWORD_STAT(STAT_PawnPoolMiss);
+
+	return Super::SpawnDefaultPawnAtTransform_Implementation(NewPlayer, SpawnTransform);
+}
+
+void AShootingGameGameMode::OnCharacterDied(AShootingGameCharacter* DeadChar)
+{
+	DeadChar->GoNetDormant();
+
+	AController* Controller = DeadChar->GetController();
+	if (IsValid(Controller) == false)
+		return;
+
+	FTimerHandle th_Respawn;
+	FTimerDelegate RespawnDelegate = FTimerDelegate::CreateUObject(this, &AShootingGameGameMode::OnRespawnTimer, TWeakObjectPtr<AController>(Controller));
+	GetWorldTimerManager().SetTimer(th_Respawn, RespawnDelegate, RespawnDelay, false);
+}
+
+void AShootingGameGameMode::RespawnPlayer(AController* Controller)
+{
+	SCOPE_CYCLE_COUNTER(STAT_Respawn);
+
+	if (IsValid(Controller) == false)
+		return;
+
+	AShootingGameCharacter* OldChar = Cast<AShootingGameCharacter>(Controller->GetPawn());
+	if (OldChar)
+	{
+		Controller->UnPossess();
+		ReleasePawn(OldChar);
+	}
+
+	AShootingPlayerState* ps = Controller->GetPlayerState<AShootingPlayerState>();
+	if (ps)
+	{
+		ps->ResetHp();
+	}
+
+	RestartPlayer(Controller);
+}
+
+void AShootingGameGameMode::ReleasePawn(AShootingGameCharacter* Char)
+{
+	if (IsValid(Char) == false || PawnPool.Contains(Char))
+		return;
+
+	Char->DeactivateToPool();
+	PawnPool.Push(Char);
+	INC_DWORD_STAT(STAT_PooledPawns);
+}
+
+void AShootingGameGameMode::OnRespawnTimer(TWeakObjectPtr<AController> Controller)
+{
+	if (Controller.IsValid())
+	{
+		RespawnPlayer(Controller.Get());
+	}
 }
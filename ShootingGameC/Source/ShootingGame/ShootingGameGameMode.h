@@ -6,6 +6,9 @@
 #include "GameFramework/GameModeBase.h"
 #include "ShootingGameGameMode.generated.h"
 
+class AShootingGameCharacter;
+class AShootingTeamInfo;
+
 UCLASS(minimalapi)
 class AShootingGameGameMode : public AGameModeBase
 {
@@ -13,7 +16,63 @@ class AShootingGameGameMode : public AGameModeBase
 
 public:
 	AShootingGameGameMode();
-};
 
+	virtual void BeginPlay() override;
+
+	virtual void PostLogin(APlayerController* NewPlayer) override;
+
+	virtual void Logout(AController* Exiting) override;
+
+	virtual APawn* SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform) override;
+
+	/** Called on the server when a character's hp drops to zero. Schedules the respawn of its controller. */
+	void OnCharacterDied(AShootingGameCharacter* DeadChar);
+
+	/** Puts the controller's current pawn back into the pool and possesses a reset one. */
+	UFUNCTION(BlueprintCallable)
+	void RespawnPlayer(AController* Controller);
+
+	/** Deactivates a character and keeps it for the next respawn instead of destroying it. */
+	void ReleasePawn(AShootingGameCharacter* Char);
+
+	/** Puts the controller's player on the team with the fewest members. Called for players on login; bots with a player state can use it too. */
+	UFUNCTION(BlueprintCallable)
+	void AssignTeam(AController* Controller);
+
+public:
+	/** Number of characters constructed up front when the match begins */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Respawn)
+	int32 PawnPoolSize;
+
+	/** Seconds a dead character stays ragdolled before its controller respawns */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Respawn)
+	float RespawnDelay;
+
+	/** Bytes per second each client connection may use; the net driver stops sending once a connection saturates it. Zero leaves the driver's rates alone. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Network)
+	int32 MaxClientNetSpeed;
+
+	/** Zero disables teams, up to 31 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Teams)
+	int32 NumTeams;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Teams)
+	bool bFriendlyFire;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Teams)
+	TSubclassOf<AShootingTeamInfo> TeamInfoClass;
 
+private:
+	/** Lowers the net driver's client rate limits to MaxClientNetSpeed; clients asking for less keep what they asked for */
+	void ApplyClientNetSpeedCap();
+
+	void OnRespawnTimer(TWeakObjectPtr<AController> Controller);
+
+	AShootingTeamInfo* GetOrSpawnTeamInfo(uint8 TeamId);
+
+	UPROPERTY()
+	TArray<AShootingGameCharacter*> PawnPool;
+
+	UPROPERTY()
+	TArray<AShootingTeamInfo*> Teams;
+};
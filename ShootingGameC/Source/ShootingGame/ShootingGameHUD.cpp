@@ -5,6 +5,9 @@
 #include "Blueprint/UserWidget.h"
 #include "Kismet/GameplayStatics.h"
 #include "ShootingPlayerState.h"
+#include "ShootingGame.h"
+
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Time To Playable"), STAT_TimeToPlayable, STATGROUP_ShootingGame);
 
 void AShootingGameHUD::OnUpdateMyHp_Implementation(float CurrentHp, float MaxHp)
 {
@@ -23,25 +26,50 @@ void AShootingGameHUD::BeginPlay()
 	HudWidget = CreateWidget<UUserWidget>(GetWorld(), HudWidgetClass);
 	HudWidget->AddToViewport();
 
-	BindPlayerState();
-}
-
-void AShootingGameHUD::BindPlayerState()
-{
 	//APlayerController* pc = UGameplayStatics::GetPlayerController(GetWorld(), 0);
 	APlayerController* pc = GetWorld()->GetFirstPlayerController();
 
-	if (IsValid(pc) && pc->PlayerState != nullptr)
+	// Otherwise AShootingPlayerState calls OnLocalPlayerStateReady when it arrives
+	if (IsValid(pc))
 	{
-		AShootingPlayerState* ps = Cast<AShootingPlayerState>(pc->PlayerState);
-		if (IsValid(ps))
-		{
-			ps->Fuc_Dele_UpdateHp_TwoParams.AddUFunction(this, FName("OnUpdateMyHp"));
-			OnUpdateMyHp(ps->GetCurHp(), ps->GetMaxHp());
-			return;
-		}
+		BindPlayerState(pc->GetPlayerState<AShootingPlayerState>());
 	}
+}
+
+void AShootingGameHUD::BindPlayerState(AShootingPlayerState* ps)
+{
+	if (IsValid(ps) == false)
+		return;
+
+	ps->Fuc_Dele_UpdateHp_TwoParams.RemoveAll(this);
+	ps->Fuc_Dele_UpdateHp_TwoParams.AddUFunction(this, FName("OnUpdateMyHp"));
+	OnUpdateMyHp(ps->GetCurHp(), ps->GetMaxHp());
+
+	IsPlayerStateBound = true;
+	CheckPlayable();
+}
+
+void AShootingGameHUD::OnLocalPlayerStateReady(AShootingPlayerState* ps)
+{
+	// The player state notifying us may arrive before pc->PlayerState is replicated, so bind to it directly
+	BindPlayerState(ps);
+}
+
+void AShootingGameHUD::OnLocalWeaponReady()
+{
+	IsWeaponReady = true;
+	CheckPlayable();
+}
+
+void AShootingGameHUD::CheckPlayable()
+{
+	if (IsPlayableReported || IsPlayerStateBound == false || IsWeaponReady == false)
+		return;
+
+	IsPlayableReported = true;
 
-	FTimerManager& timerManager = GetWorld()->GetTimerManager();
-	timerManager.SetTimer(th_BindPlayerState, this, &AShootingGameHUD::BindPlayerState, 0.1f, false);
+	// Real time since the world was created, so map load plus initial replication
+	float TimeToPlayable = GetWorld()->GetRealTimeSeconds();
+	SET_FLOAT_STAT(STAT_TimeToPlayable, TimeToPlayable);
+	UE_LOG(LogShootingGame, Log, TEXT("Time to playable: %.3f s"), TimeToPlayable);
 }
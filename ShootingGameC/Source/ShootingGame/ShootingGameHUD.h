@@ -32,11 +32,24 @@ public:
 
 	void OnUpdateMyAmmo_Implementation(int Ammo);
 
+	/** Called by the local player state once it has replicated, so the HUD never polls for it */
+	void OnLocalPlayerStateReady(class AShootingPlayerState* ps);
+
+	/** Called when the locally controlled character's weapon is ready to fire */
+	void OnLocalWeaponReady();
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-	void BindPlayerState();
+	void BindPlayerState(class AShootingPlayerState* ps);
+
+	/** Logs time-to-playable the first time player state and weapon are both ready */
+	void CheckPlayable();
+
+	bool IsPlayerStateBound = false;
+
+	bool IsWeaponReady = false;
 
-	FTimerHandle th_BindPlayerState;
+	bool IsPlayableReported = false;
 };
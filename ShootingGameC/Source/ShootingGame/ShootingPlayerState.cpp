@@ -2,39 +2,341 @@
 
 
 #include "ShootingPlayerState.h"
+#include "ShootingGame.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "Kismet/GameplayStatics.h"
+#include "TimerManager.h"
 #include "ShootingGameHUD.h"
+#include "ShootingGameCharacter.h"
+#include "ShootingGameGameMode.h"
+#include "NetClockSyncComponent.h"
+#include "ShootingTeamInfo.h"
+
+void FStatusEffect::PostReplicatedAdd(const FStatusEffectArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->OnStatusEffectsChanged();
+	}
+}
+
+void FStatusEffect::PreReplicatedRemove(const FStatusEffectArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner)
+	{
+		InArraySerializer.Owner->OnStatusEffectsChanged();
+	}
+}
 
 void AShootingPlayerState::GetLifetimeReplicatedProps(TArray< FLifetimeProperty >& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(AShootingPlayerState, CurHp);
-	DOREPLIFETIME(AShootingPlayerState, MaxHp);
+	FDoRepLifetimeParams PushParams;
+	PushParams.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShootingPlayerState, CurHp, PushParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShootingPlayerState, MaxHp, PushParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShootingPlayerState, HpTime, PushParams);
+	DOREPLIFETIME(AShootingPlayerState, StatusEffects);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShootingPlayerState, TeamId, PushParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShootingPlayerState, TeamInfo, PushParams);
 }
 
 AShootingPlayerState::AShootingPlayerState()
 {
 	CurHp = 100.0f;
 	MaxHp = 100.0f;
+	HpTime = 0.0f;
+
+	TeamId = NoTeam;
+	TeamInfo = nullptr;
+	DamageMask = ~0u;
+
+	JoinNetPriorityTime = 10.0f;
+	JoinOwnerNetPriorityScale = 8.0f;
+	JoinOtherNetPriorityScale = 0.5f;
+
+	ClockSync = CreateDefaultSubobject<UNetClockSyncComponent>(TEXT("ClockSync"));
+}
+
+void AShootingPlayerState::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	StatusEffects.Owner = this;
+}
+
+void AShootingPlayerState::BeginPlay()
+{
+	Super::BeginPlay();
+
+	NotifyLocallyOwned();
+}
+
+void AShootingPlayerState::OnRep_Owner()
+{
+	Super::OnRep_Owner();
+
+	NotifyLocallyOwned();
+}
+
+float AShootingPlayerState::GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth)
+{
+	float Priority = Super::GetNetPriority(ViewPos, ViewDir, Viewer, ViewTarget, InChannel, Time, bLowBandwidth);
+
+	// A joining client needs its own player state before anyone else's, but only until it has settled in
+	if (Viewer == nullptr || Viewer->GetGameTimeSinceCreation() >= JoinNetPriorityTime)
+		return Priority;
+
+	return (Viewer == GetOwner()) ? Priority * JoinOwnerNetPriorityScale : Priority * JoinOtherNetPriorityScale;
+}
+
+uint32 AShootingPlayerState::GetDamageMask(const AController* Controller)
+{
+	const AShootingPlayerState* ps = Controller ? Controller->GetPlayerState<AShootingPlayerState>() : nullptr;
+	return ps ? ps->GetDamageMask() : ~0u;
+}
+
+void AShootingPlayerState::SetTeam(uint8 NewTeamId, AShootingTeamInfo* NewTeamInfo, bool bFriendlyFire)
+{
+	if (HasAuthority() == false)
+		return;
+
+	if (TeamInfo != NewTeamInfo)
+	{
+		if (TeamInfo)
+		{
+			TeamInfo->RemoveMember(this);
+		}
+		if (NewTeamInfo)
+		{
+			NewTeamInfo->AddMember(this);
+		}
+		TeamInfo = NewTeamInfo;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AShootingPlayerState, TeamInfo, this);
+	}
+
+	TeamId = NewTeamId;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShootingPlayerState, TeamId, this);
+
+	// Without a team, or with friendly fire on, damage applies to everyone
+	DamageMask = (bFriendlyFire || TeamId == NoTeam) ? ~0u : ~GetTeamMask();
+
+	AShootingGameCharacter* Char = Cast<AShootingGameCharacter>(GetPawn());
+	if (Char)
+	{
+		Char->RefreshTeam();
+	}
+}
+
+void AShootingPlayerState::NotifyLocallyOwned()
+{
+	APlayerController* pc = Cast<APlayerController>(GetOwner());
+	if (pc == nullptr || pc->IsLocalController() == false)
+		return;
+
+	ClockSync->StartSync();
+
+	AShootingGameHUD* Hud = Cast<AShootingGameHUD>(pc->GetHUD());
+	if (IsValid(Hud))
+	{
+		Hud->OnLocalPlayerStateReady(this);
+	}
 }
 
 void AShootingPlayerState::OnRep_CurHp()
 {
-	GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Yellow, FString::Printf(TEXT("OnRep_CurHp = %f"), CurHp));
+	float Hp = GetCurHp();
+
+	SHOOTING_DEBUG_MESSAGE(TEXT("OnRep_CurHp = %f"), Hp);
 
 	if(Fuc_Dele_UpdateHp_TwoParams.IsBound())
-		Fuc_Dele_UpdateHp_TwoParams.Broadcast(CurHp, MaxHp);
+		Fuc_Dele_UpdateHp_TwoParams.Broadcast(Hp, MaxHp);
 }
 
 void AShootingPlayerState::OnRep_MaxHp()
 {
 }
 
+float AShootingPlayerState::GetCurHp() const
+{
+	if (StatusEffects.Items.Num() == 0)
+		return CurHp;
+
+	return EvaluateHp(GetServerTime());
+}
+
 void AShootingPlayerState::AddDamage(float Damage)
 {
+	FoldStatusEffects();
+
 	CurHp = CurHp - Damage;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShootingPlayerState, CurHp, this);
+
+	OnRep_CurHp();
+
+	ScheduleNextEffectEvent();
+}
 
+void AShootingPlayerState::ResetHp()
+{
+	StatusEffects.Items.Reset();
+	StatusEffects.MarkArrayDirty();
+	GetWorldTimerManager().ClearTimer(th_EffectEvent);
+
+	CurHp = MaxHp;
+	HpTime = GetServerTime();
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShootingPlayerState, CurHp, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShootingPlayerState, HpTime, this);
+
+	OnRep_CurHp();
+}
+
+void AShootingPlayerState::AddStatusEffect(uint8 EffectId, float Rate, float Duration)
+{
+	if (HasAuthority() == false)
+		return;
+
+	FoldStatusEffects();
+
+	FStatusEffect* Effect = StatusEffects.Items.FindByPredicate([EffectId](const FStatusEffect& Item) { return Item.EffectId == EffectId; });
+	if (Effect == nullptr)
+	{
+		Effect = &StatusEffects.Items.AddDefaulted_GetRef();
+		Effect->EffectId = EffectId;
+	}
+
+	Effect->StartTime = HpTime;
+	Effect->Rate = Rate;
+	Effect->Duration = Duration;
+	StatusEffects.MarkItemDirty(*Effect);
+
+	OnStatusEffectsChanged();
+	ScheduleNextEffectEvent();
+}
+
+void AShootingPlayerState::RemoveStatusEffect(uint8 EffectId)
+{
+	if (HasAuthority() == false)
+		return;
+
+	FoldStatusEffects();
+
+	int32 Removed = StatusEffects.Items.RemoveAll([EffectId](const FStatusEffect& Item) { return Item.EffectId == EffectId; });
+	if (Removed > 0)
+	{
+		StatusEffects.MarkArrayDirty();
+		OnStatusEffectsChanged();
+	}
+
+	ScheduleNextEffectEvent();
+}
+
+void AShootingPlayerState::OnStatusEffectsChanged()
+{
+	OnRep_CurHp();
+}
+
+float AShootingPlayerState::GetServerTime() const
+{
+	return (float)UNetClockSyncComponent::GetServerTime(GetWorld());
+}
+
+float AShootingPlayerState::EvaluateHp(float Time) const
+{
+	float Hp = CurHp;
+
+	for (const FStatusEffect& Effect : StatusEffects.Items)
+	{
+		const float Start = FMath::Max(Effect.StartTime, HpTime);
+		const float End = FMath::Min(Effect.GetEndTime(), Time);
+		if (End > Start)
+		{
+			Hp += Effect.Rate * (End - Start);
+		}
+	}
+
+	return FMath::Min(Hp, MaxHp);
+}
+
+void AShootingPlayerState::FoldStatusEffects()
+{
+	if (HasAuthority() == false)
+		return;
+
+	const float Now = GetServerTime();
+
+	if (StatusEffects.Items.Num() > 0)
+	{
+		CurHp = EvaluateHp(Now);
+		MARK_PROPERTY_DIRTY_FROM_NAME(AShootingPlayerState, CurHp, this);
+
+		int32 Removed = StatusEffects.Items.RemoveAll([Now](const FStatusEffect& Item) { return Item.GetEndTime() <= Now; });
+		if (Removed > 0)
+		{
+			StatusEffects.MarkArrayDirty();
+		}
+	}
+
+	HpTime = Now;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShootingPlayerState, HpTime, this);
+}
+
+void AShootingPlayerState::ScheduleNextEffectEvent()
+{
+	if (HasAuthority() == false)
+		return;
+
+	GetWorldTimerManager().ClearTimer(th_EffectEvent);
+
+	if (StatusEffects.Items.Num() == 0 || CurHp <= 0)
+		return;
+
+	// Between events every rate is constant, so the next event is the earliest of an effect ending or hp reaching zero
+	float NetRate = 0.0f;
+	float NextEvent = MAX_FLT;
+	for (const FStatusEffect& Effect : StatusEffects.Items)
+	{
+		NetRate += Effect.Rate;
+		NextEvent = FMath::Min(NextEvent, Effect.GetEndTime());
+	}
+
+	if (NetRate < 0.0f)
+	{
+		NextEvent = FMath::Min(NextEvent, HpTime + CurHp / -NetRate);
+	}
+
+	if (NextEvent < MAX_FLT)
+	{
+		GetWorldTimerManager().SetTimer(th_EffectEvent, this, &AShootingPlayerState::OnEffectEvent, FMath::Max(NextEvent - HpTime, 0.01f), false);
+	}
+}
+
+void AShootingPlayerState::OnEffectEvent()
+{
+	FoldStatusEffects();
 	OnRep_CurHp();
+
+	if (CurHp <= 0)
+	{
+		AShootingGameCharacter* Char = Cast<AShootingGameCharacter>(GetPawn());
+		AShootingGameGameMode* gm = GetWorld()->GetAuthGameMode<AShootingGameGameMode>();
+		if (Char && gm)
+		{
+			gm->OnCharacterDied(Char);
+		}
+		return;
+	}
+
+	ScheduleNextEffectEvent();
+}
+
+void AShootingPlayerState::ResCosmeticEvents_Implementation(const TArray<FCosmeticEvent>& Events)
+{
+	for (const FCosmeticEvent& Event : Events)
+	{
+		Event.Play();
+	}
 }
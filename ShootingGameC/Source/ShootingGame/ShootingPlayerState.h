@@ -4,9 +4,67 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/PlayerState.h"
+#include "Engine/NetSerialization.h"
+#include "CosmeticEventSubsystem.h"
 #include "ShootingPlayerState.generated.h"
 
 DECLARE_MULTICAST_DELEGATE_TwoParams(FDele_Multi_UpdateHp_TwoParams, float, float);
+
+/**
+ * A health-over-time effect (regen, bleed, buff) stored as a linear rate over a time window.
+ * Health is integrated from these records when read, so active effects cost nothing per frame.
+ */
+USTRUCT()
+struct FStatusEffect : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint8 EffectId = 0;
+
+	/** Server time the effect started */
+	UPROPERTY()
+	float StartTime = 0.0f;
+
+	/** Hp per second, negative for damage over time */
+	UPROPERTY()
+	float Rate = 0.0f;
+
+	/** Seconds, or zero for an effect that lasts until removed */
+	UPROPERTY()
+	float Duration = 0.0f;
+
+	FORCEINLINE float GetEndTime() const { return Duration > 0.0f ? StartTime + Duration : MAX_FLT; }
+
+	void PostReplicatedAdd(const struct FStatusEffectArray& InArraySerializer);
+	void PreReplicatedRemove(const struct FStatusEffectArray& InArraySerializer);
+};
+
+USTRUCT()
+struct FStatusEffectArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FStatusEffect> Items;
+
+	UPROPERTY(NotReplicated)
+	class AShootingPlayerState* Owner = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FStatusEffect, FStatusEffectArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FStatusEffectArray> : public TStructOpsTypeTraitsBase2<FStatusEffectArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
 /**
  * 
  */
@@ -14,24 +72,78 @@ UCLASS()
 class SHOOTINGGAME_API AShootingPlayerState : public APlayerState
 {
 	GENERATED_BODY()
+
+	/** Server clock estimate for the owning client */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Replication, meta = (AllowPrivateAccess = "true"))
+	class UNetClockSyncComponent* ClockSync;
 	
 public:
 	AShootingPlayerState();
 
+	FORCEINLINE class UNetClockSyncComponent* GetClockSync() const { return ClockSync; }
+
+	/** TeamId of players without a team. Teams use 0-30 so every team fits one bit of a uint32 mask. */
+	static const uint8 NoTeam = 255;
+
+	/** Bit of a team in team and damage masks; players without a team share the top bit */
+	static FORCEINLINE uint32 ToTeamMask(uint8 InTeamId) { return 1u << FMath::Min<uint32>(InTeamId, 31); }
+
+	UFUNCTION(BlueprintPure)
+	FORCEINLINE uint8 GetTeamId() const { return TeamId; }
+
+	FORCEINLINE uint32 GetTeamMask() const { return ToTeamMask(TeamId); }
+
+	FORCEINLINE class AShootingTeamInfo* GetTeamInfo() const { return TeamInfo; }
+
+	/** Server: team masks this player's damage applies to */
+	FORCEINLINE uint32 GetDamageMask() const { return DamageMask; }
+
+	/** Server: damage mask of Controller's player state, or every team for controllers without one */
+	static uint32 GetDamageMask(const class AController* Controller);
+
+	/** Server: moves the player to a team and updates its pawn's cached team */
+	void SetTeam(uint8 NewTeamId, class AShootingTeamInfo* NewTeamInfo, bool bFriendlyFire);
+
+	virtual void PostInitializeComponents() override;
+
+	virtual void BeginPlay() override;
+
+	virtual void OnRep_Owner() override;
+
+	virtual float GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth) override;
+
 protected:
+	/** Hp at HpTime, before the status effects running since then are applied */
 	UPROPERTY(ReplicatedUsing = OnRep_CurHp)
 	float CurHp;
 
+	UPROPERTY(Replicated)
+	float HpTime;
+
 	UPROPERTY(ReplicatedUsing = OnRep_MaxHp)
 	float MaxHp;
 
 public:
+	/** Current hp including every status effect, evaluated at the current server time */
 	UFUNCTION(BlueprintPure)
-	FORCEINLINE float GetCurHp() const { return CurHp; }
+	float GetCurHp() const;
 
 	UFUNCTION(BlueprintPure)
 	FORCEINLINE float GetMaxHp() const { return MaxHp; }
 
+protected:
+	/** Seconds after a client's controller spawns during which its own player state goes out ahead of the others */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replication)
+	float JoinNetPriorityTime;
+
+	/** Priority multiplier toward the owning client while it is joining */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replication)
+	float JoinOwnerNetPriorityScale;
+
+	/** Priority multiplier toward a joining client for everyone else's player state */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Replication)
+	float JoinOtherNetPriorityScale;
+
 public:
 	UFUNCTION()
 	void OnRep_CurHp();
@@ -42,5 +154,52 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void AddDamage(float Damage);
 
+	UFUNCTION(BlueprintCallable)
+	void ResetHp();
+
+	/** Starts a status effect on the server. Adding an EffectId that is already running restarts it. */
+	UFUNCTION(BlueprintCallable)
+	void AddStatusEffect(uint8 EffectId, float Rate, float Duration);
+
+	UFUNCTION(BlueprintCallable)
+	void RemoveStatusEffect(uint8 EffectId);
+
+	/** Called when a status effect starts or stops on this machine */
+	void OnStatusEffectsChanged();
+
+	/** This frame's cosmetic events near the owning client, from UCosmeticEventSubsystem */
+	UFUNCTION(Client, Unreliable)
+	void ResCosmeticEvents(const TArray<FCosmeticEvent>& Events);
+
 	FDele_Multi_UpdateHp_TwoParams Fuc_Dele_UpdateHp_TwoParams;
+
+private:
+	float GetServerTime() const;
+
+	/** Hp at Time from CurHp and the effects overlapping [HpTime, Time] */
+	float EvaluateHp(float Time) const;
+
+	/** Bakes effects into CurHp up to now and drops the finished ones. Server only. */
+	void FoldStatusEffects();
+
+	/** Arms one timer for the next moment hp can hit zero or an effect ends */
+	void ScheduleNextEffectEvent();
+
+	void OnEffectEvent();
+
+	/** Lets the local HUD bind and starts clock sync as soon as this player state exists on its owning client */
+	void NotifyLocallyOwned();
+
+	UPROPERTY(Replicated)
+	FStatusEffectArray StatusEffects;
+
+	UPROPERTY(Replicated)
+	uint8 TeamId;
+
+	UPROPERTY(Replicated)
+	class AShootingTeamInfo* TeamInfo;
+
+	uint32 DamageMask;
+
+	FTimerHandle th_EffectEvent;
 };
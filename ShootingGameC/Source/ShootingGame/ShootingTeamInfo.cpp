@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShootingTeamInfo.h"
+#include "ShootingGame.h"
+#include "ShootingPlayerState.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/Pawn.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "TimerManager.h"
+
+void AShootingTeamInfo::GetLifetimeReplicatedProps(TArray< FLifetimeProperty >& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams PushParams;
+	PushParams.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShootingTeamInfo, TeamId, PushParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShootingTeamInfo, Members, PushParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AShootingTeamInfo, MemberLocations, PushParams);
+}
+
+AShootingTeamInfo::AShootingTeamInfo()
+{
+	bReplicates = true;
+	bAlwaysRelevant = false;
+	NetUpdateFrequency = 2.0f;
+	NetPriority = 0.5f;
+
+	MemberUpdateInterval = 0.5f;
+	TeamId = AShootingPlayerState::NoTeam;
+}
+
+void AShootingTeamInfo::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (HasAuthority())
+	{
+		GetWorldTimerManager().SetTimer(th_UpdateMembers, this, &AShootingTeamInfo::UpdateMemberLocations, MemberUpdateInterval, true);
+	}
+}
+
+bool AShootingTeamInfo::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	// Team-only: enemies never receive this actor, regardless of distance
+	const AController* Controller = Cast<AController>(RealViewer);
+	const AShootingPlayerState* ps = Controller ? Controller->GetPlayerState<AShootingPlayerState>() : nullptr;
+	return ps && ps->GetTeamId() == TeamId;
+}
+
+void AShootingTeamInfo::Init(uint8 InTeamId)
+{
+	TeamId = InTeamId;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShootingTeamInfo, TeamId, this);
+}
+
+void AShootingTeamInfo::AddMember(AShootingPlayerState* Member)
+{
+	if (Members.Contains(Member))
+		return;
+
+	Members.Add(Member);
+	MemberLocations.SetNum(Members.Num());
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShootingTeamInfo, Members, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShootingTeamInfo, MemberLocations, this);
+}
+
+void AShootingTeamInfo::RemoveMember(AShootingPlayerState* Member)
+{
+	const int32 Index = Members.Find(Member);
+	if (Index == INDEX_NONE)
+		return;
+
+	Members.RemoveAt(Index);
+	MemberLocations.RemoveAt(Index);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShootingTeamInfo, Members, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AShootingTeamInfo, MemberLocations, this);
+}
+
+void AShootingTeamInfo::UpdateMemberLocations()
+{
+	bool Changed = false;
+	for (int32 i = 0; i < Members.Num(); ++i)
+	{
+		const APawn* Pawn = IsValid(Members[i]) ? Members[i]->GetPawn() : nullptr;
+		if (Pawn == nullptr)
+			continue;
+
+		// Compare at the replicated precision so a standing teammate does not redirty the array
+		const FVector Location = Pawn->GetActorLocation().GridSnap(1.0f);
+		if (MemberLocations[i] != Location)
+		{
+			MemberLocations[i] = Location;
+			Changed = true;
+		}
+	}
+
+	if (Changed)
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(AShootingTeamInfo, MemberLocations, this);
+	}
+}
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "Engine/NetSerialization.h"
+#include "ShootingTeamInfo.generated.h"
+
+class AShootingPlayerState;
+
+/**
+ * Server-spawned actor per team holding data only that team's members receive,
+ * such as where every teammate is even while their characters are out of range.
+ */
+UCLASS()
+class SHOOTINGGAME_API AShootingTeamInfo : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	AShootingTeamInfo();
+
+	virtual void BeginPlay() override;
+
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
+	FORCEINLINE uint8 GetTeamId() const { return TeamId; }
+
+	FORCEINLINE int32 GetNumMembers() const { return Members.Num(); }
+
+	UFUNCTION(BlueprintPure)
+	FORCEINLINE TArray<AShootingPlayerState*> GetMembers() const { return Members; }
+
+	/** Teammate positions, in the order of GetMembers. Refreshed every MemberUpdateInterval. */
+	UFUNCTION(BlueprintPure)
+	FORCEINLINE TArray<FVector_NetQuantize> GetMemberLocations() const { return MemberLocations; }
+
+	/** Server */
+	void Init(uint8 InTeamId);
+
+	void AddMember(AShootingPlayerState* Member);
+
+	void RemoveMember(AShootingPlayerState* Member);
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Team)
+	float MemberUpdateInterval;
+
+private:
+	void UpdateMemberLocations();
+
+	UPROPERTY(Replicated)
+	uint8 TeamId;
+
+	UPROPERTY(Replicated)
+	TArray<AShootingPlayerState*> Members;
+
+	UPROPERTY(Replicated)
+	TArray<FVector_NetQuantize> MemberLocations;
+
+	FTimerHandle th_UpdateMembers;
+};
@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShotResolutionSubsystem.h"
+#include "ShootingGame.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Shot Resolution"), STAT_ShotResolution, STATGROUP_ShootingGame);
+DECLARE_CYCLE_STAT(TEXT("Shot Resolution Apply"), STAT_ShotResolutionApply, STATGROUP_ShootingGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Resolved Shots"), STAT_ResolvedShots, STATGROUP_ShootingGame);
+
+static TAutoConsoleVariable<int32> CVarShotResolutionParallel(
+	TEXT("sg.ShotResolutionParallel"),
+	1,
+	TEXT("Resolve queued hitscan shots on worker threads.\n")
+	TEXT("0: resolve on the game thread, 1: use ParallelFor"));
+
+void UShotResolutionSubsystem::QueueShot(AWeapon* Weapon, const FVector& vStart, const FVector& vEnd)
+{
+	if (GetWorld()->GetNetMode() == NM_Client)
+		return;
+
+	PendingShots.Add({ Weapon, vStart, vEnd });
+}
+
+void UShotResolutionSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ShotResolution);
+
+	const int32 Num = PendingShots.Num();
+	INC_DWORD_STAT_BY(STAT_ResolvedShots, Num);
+
+	if (Results.Num() < Num)
+	{
+		Results.SetNum(Num);
+	}
+
+	// Weak pointers are resolved here so workers only see raw, already checked weapons
+	Weapons.Reset();
+	for (const FPendingShot& Shot : PendingShots)
+	{
+		Weapons.Add(Shot.Weapon.Get());
+	}
+
+	// Scene queries take the physics scene read lock themselves, and ResolveShot touches nothing but its own result
+	ParallelFor(Num, [this](int32 i)
+	{
+		FShotResult& Result = Results[i];
+		Result.Victims.Reset();
+		Result.IsValid = false;
+		Result.IsHit = false;
+
+		if (Weapons[i])
+		{
+			Weapons[i]->ResolveShot(PendingShots[i].Start, PendingShots[i].End, Result);
+		}
+	}, CVarShotResolutionParallel.GetValueOnGameThread() == 0);
+
+	// Damage can kill, respawn and spawn, so it stays on the game thread and in request order
+	{
+		SCOPE_CYCLE_COUNTER(STAT_ShotResolutionApply);
+
+		for (int32 i = 0; i < Num; ++i)
+		{
+			if (Weapons[i] && Results[i].IsValid)
+			{
+				Weapons[i]->ApplyShot(PendingShots[i].Start, PendingShots[i].End, Results[i]);
+			}
+		}
+	}
+
+	PendingShots.Reset();
+}
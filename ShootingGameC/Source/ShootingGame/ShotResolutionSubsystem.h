@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Weapon.h"
+#include "ShotResolutionSubsystem.generated.h"
+
+/** Outcome of the worker-side part of a hitscan shot */
+struct FShotResult
+{
+	FHitResult Hit;
+	TArray<FPenetrationVictim> Victims;
+	FPenetrationScratch Scratch;
+	bool IsValid;
+	bool IsHit;
+};
+
+/**
+ * Collects the frame's hitscan shot requests on the server and resolves them together:
+ * validation and scene queries run in parallel, then damage, explosions and debug output are applied
+ * on the game thread in the order the requests arrived.
+ */
+UCLASS()
+class SHOOTINGGAME_API UShotResolutionSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	void QueueShot(AWeapon* Weapon, const FVector& vStart, const FVector& vEnd);
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return PendingShots.Num() > 0; }
+	virtual ETickableTickType GetTickableTickType() const override { return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional; }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(UShotResolutionSubsystem, STATGROUP_Tickables); }
+
+private:
+	struct FPendingShot
+	{
+		TWeakObjectPtr<AWeapon> Weapon;
+		FVector Start;
+		FVector End;
+	};
+
+	TArray<FPendingShot> PendingShots;
+
+	TArray<AWeapon*> Weapons;
+
+	// Kept between frames, including each result's victims and hit buffers, so resolving shots does not allocate once warmed up
+	TArray<FShotResult> Results;
+};
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Math/RandomStream.h"
+#include "CharacterSpatialIndex.h"
+#include "ShootingGameCharacter.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCharacterSpatialIndexBenchmark, "ShootingGame.SpatialIndex.BenchmarkVsOverlap",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+namespace CharacterSpatialIndexBenchmark
+{
+	const float WorldExtent = 20000.0f;
+	const float QueryRadius = 2500.0f;
+	const int32 NumQueries = 1000;
+
+	/** Times NumQueries radius queries over NumCharacters characters both ways and logs the per-query cost */
+	void Run(FAutomationTestBase& Test, int32 NumCharacters)
+	{
+		UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+		World->InitializeActorsForPlay(FURL());
+		World->BeginPlay();
+
+		FRandomStream Random(NumCharacters);
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		for (int32 i = 0; i < NumCharacters; ++i)
+		{
+			const FVector Location(Random.FRandRange(-WorldExtent, WorldExtent), Random.FRandRange(-WorldExtent, WorldExtent), 0.0f);
+			World->SpawnActor<AShootingGameCharacter>(Location, FRotator::ZeroRotator, SpawnParams);
+		}
+
+		TArray<FVector> Centers;
+		for (int32 i = 0; i < NumQueries; ++i)
+		{
+			Centers.Add(FVector(Random.FRandRange(-WorldExtent, WorldExtent), Random.FRandRange(-WorldExtent, WorldExtent), 0.0f));
+		}
+
+		UCharacterSpatialIndex* SpatialIndex = World->GetSubsystem<UCharacterSpatialIndex>();
+		Test.TestEqual(FString::Printf(TEXT("%d characters indexed"), NumCharacters), SpatialIndex->Num(), NumCharacters);
+
+		// Spatial index
+		int64 IndexFound = 0;
+		double StartTime = FPlatformTime::Seconds();
+		for (const FVector& Center : Centers)
+		{
+			SpatialIndex->ForEachInRadius(Center, QueryRadius, [&](AShootingGameCharacter* Char, const FVector& Location, float DistSq)
+			{
+				++IndexFound;
+			});
+		}
+		const double IndexTime = FPlatformTime::Seconds() - StartTime;
+
+		// Physics scene overlap against the same pawn capsules
+		int64 OverlapFound = 0;
+		TArray<FOverlapResult> Overlaps;
+		const FCollisionObjectQueryParams ObjectParams(ECC_Pawn);
+		const FCollisionShape Sphere = FCollisionShape::MakeSphere(QueryRadius);
+		StartTime = FPlatformTime::Seconds();
+		for (const FVector& Center : Centers)
+		{
+			Overlaps.Reset();
+			World->OverlapMultiByObjectType(Overlaps, Center, FQuat::Identity, ObjectParams, Sphere);
+			for (const FOverlapResult& Overlap : Overlaps)
+			{
+				if (Cast<AShootingGameCharacter>(Overlap.GetActor()))
+				{
+					++OverlapFound;
+				}
+			}
+		}
+		const double OverlapTime = FPlatformTime::Seconds() - StartTime;
+
+		Test.AddInfo(FString::Printf(TEXT("%5d characters: ForEachInRadius %.2f us/query (%lld found), OverlapMultiByObjectType %.2f us/query (%lld found)"),
+			NumCharacters, IndexTime * 1e6 / NumQueries, IndexFound, OverlapTime * 1e6 / NumQueries, OverlapFound));
+
+		// The index tests character centers, the overlap whole capsules, so it can only find fewer
+		Test.TestTrue(FString::Printf(TEXT("%d characters: index finds no character the overlap misses"), NumCharacters), IndexFound <= OverlapFound);
+
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+}
+
+bool FCharacterSpatialIndexBenchmark::RunTest(const FString& Parameters)
+{
+	CharacterSpatialIndexBenchmark::Run(*this, 64);
+	CharacterSpatialIndexBenchmark::Run(*this, 256);
+	CharacterSpatialIndexBenchmark::Run(*this, 1024);
+	return true;
+}
+
+#endif
@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Math/RandomStream.h"
+#include "NetClockSyncComponent.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNetClockSyncJitterTest, "ShootingGame.ClockSync.JitteredLink",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+namespace NetClockSyncTest
+{
+	struct FPacket
+	{
+		double ClientTime;
+		double ServerTime;
+		float HoldTime;
+		double ArriveTime;
+	};
+
+	/**
+	 * Runs the estimator over an emulated link with up to MaxJitter of queueing in each direction, with the pre-sync fallback
+	 * off by FallbackError, and checks the shown server time ends within MaxError of the server's
+	 */
+	void RunLink(FAutomationTestBase& Test, const TCHAR* What, double FallbackError, double MaxJitter, double MaxError)
+	{
+		const double TrueOffset = 500.0;
+		const double Latency = 0.04;
+		const float FrameTime = 1.0f / 60.0f;
+		const float MaxSlewRate = 0.05f;
+
+		FRandomStream Random(1234);
+		FClockSyncEstimator Estimator;
+		TArray<FPacket> InFlight;
+
+		double LocalTime = 10.0;
+		double NextRequestTime = LocalTime;
+		double LastShown = LocalTime + TrueOffset + FallbackError;
+		bool IsMonotonic = true;
+
+		for (int32 Frame = 0; Frame < 60 * 30; ++Frame)
+		{
+			LocalTime += FrameTime;
+
+			if (LocalTime >= NextRequestTime)
+			{
+				// Each direction gets its own jitter, so the midpoint assumption is never exact
+				const double Up = Latency * 0.5 + Random.FRand() * MaxJitter;
+				const double Down = Latency * 0.5 + Random.FRand() * MaxJitter;
+				const float Hold = Random.FRand() * FrameTime;
+
+				FPacket& Packet = InFlight.AddDefaulted_GetRef();
+				Packet.ClientTime = LocalTime;
+				Packet.ServerTime = LocalTime + Up + TrueOffset;
+				Packet.HoldTime = Hold;
+				Packet.ArriveTime = LocalTime + Up + Hold + Down;
+
+				NextRequestTime += Estimator.GetTotalSamples() < 10 ? 0.1 : 1.0;
+			}
+
+			// Replies are only read at the start of a frame, like the RPC
+			for (int32 i = InFlight.Num() - 1; i >= 0; --i)
+			{
+				if (InFlight[i].ArriveTime > LocalTime)
+					continue;
+
+				if (Estimator.IsSynced() == false)
+				{
+					Estimator.Seed(TrueOffset + FallbackError);
+				}
+				Estimator.AddSample(InFlight[i].ClientTime, InFlight[i].ServerTime, InFlight[i].HoldTime, LocalTime);
+				InFlight.RemoveAtSwap(i);
+			}
+
+			Estimator.Slew(FrameTime, MaxSlewRate);
+
+			const double Shown = LocalTime + (Estimator.IsSynced() ? Estimator.GetCurrentOffset() : TrueOffset + FallbackError);
+			if (Shown < LastShown)
+			{
+				IsMonotonic = false;
+			}
+			LastShown = Shown;
+		}
+
+		Test.TestTrue(FString::Printf(TEXT("%s: synced"), What), Estimator.IsSynced());
+		Test.TestTrue(FString::Printf(TEXT("%s: server time never ran backward"), What), IsMonotonic);
+		Test.TestTrue(FString::Printf(TEXT("%s: offset within %.1f ms (error %.4f)"), What, MaxError * 1000.0, Estimator.GetCurrentOffset() - TrueOffset),
+			FMath::Abs(Estimator.GetCurrentOffset() - TrueOffset) < MaxError);
+		Test.TestTrue(FString::Printf(TEXT("%s: round trip at least the link latency"), What),
+			Estimator.GetBestRoundTripTime() >= Latency - KINDA_SMALL_NUMBER && Estimator.GetBestRoundTripTime() <= Latency + MaxJitter * 2.0 + FrameTime);
+		Test.TestTrue(FString::Printf(TEXT("%s: jitter measured"), What), Estimator.GetJitter() > 0.0f);
+	}
+}
+
+bool FNetClockSyncJitterTest::RunTest(const FString& Parameters)
+{
+	// A quiet link: the best sample's midpoint is off by a few ms at most
+	NetClockSyncTest::RunLink(*this, TEXT("Low jitter"), 0.0, 0.005, 0.005);
+
+	// The offset of a sample is off by half the difference between its two legs, minus half the frame it waited to be read.
+	// With 30 ms of independent queueing each way even the fastest sample in the window can be lopsided, so allow that worst case.
+	const double WorstCaseError = (0.03 + 1.0 / 60.0) * 0.5;
+
+	// The game state's estimate can be on either side of the synced one
+	NetClockSyncTest::RunLink(*this, TEXT("Fallback ahead"), 0.08, 0.03, WorstCaseError);
+	NetClockSyncTest::RunLink(*this, TEXT("Fallback behind"), -0.08, 0.03, WorstCaseError);
+	NetClockSyncTest::RunLink(*this, TEXT("Fallback exact"), 0.0, 0.03, WorstCaseError);
+	return true;
+}
+
+#endif
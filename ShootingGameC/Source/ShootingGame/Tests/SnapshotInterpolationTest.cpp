@@ -0,0 +1,165 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Math/RandomStream.h"
+#include "ShootingCharacterMovementComponent.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnapshotInterpolationJitterTest, "ShootingGame.Movement.SnapshotInterpolationJitter",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSnapshotInterpolationAimOnlyTest, "ShootingGame.Movement.SnapshotInterpolationAimOnly",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+namespace SnapshotInterpolationTest
+{
+	const float Radius = 500.0f;
+	const float AngularSpeed = 1.2f;
+
+	/** The server's character at server time Time: running a circle while sweeping its aim */
+	FMoveSnapshotBuffer::FSnapshot GetTruePose(float Time)
+	{
+		const float Angle = Time * AngularSpeed;
+
+		FMoveSnapshotBuffer::FSnapshot Pose;
+		Pose.ServerTime = Time;
+		Pose.Location = FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f) * Radius;
+		Pose.Velocity = FVector(-FMath::Sin(Angle), FMath::Cos(Angle), 0.0f) * Radius * AngularSpeed;
+		Pose.Rotation = FRotator(0.0f, FMath::RadiansToDegrees(Angle) + 90.0f, 0.0f).Quaternion();
+		Pose.Pitch = 30.0f * FMath::Sin(Time * 2.0f);
+		return Pose;
+	}
+
+	/** The same character standing at the circle's start, only sweeping its aim */
+	FMoveSnapshotBuffer::FSnapshot GetTrueAimOnlyPose(float Time)
+	{
+		FMoveSnapshotBuffer::FSnapshot Pose = GetTruePose(0.0f);
+		Pose.ServerTime = Time;
+		Pose.Velocity = FVector::ZeroVector;
+		Pose.Pitch = GetTruePose(Time).Pitch;
+		return Pose;
+	}
+
+	struct FPacket
+	{
+		float ArriveTime;
+		FMoveSnapshotBuffer::FSnapshot Snapshot;
+	};
+
+	const float SendInterval = 1.0f / 30.0f;
+	const float Latency = 0.05f;
+	const float MaxJitter = 0.04f;
+	const float DropChance = 0.1f;
+	const float FrameTime = 1.0f / 60.0f;
+	const float Duration = 10.0f;
+	const float WarmUp = 1.0f;
+
+	/** Replays the server's states through the buffer and checks the interpolated poses against GetPose */
+	void Replay(FAutomationTestBase& Test, FMoveSnapshotBuffer::FSnapshot (*GetPose)(float), bool IsAimOnly)
+	{
+		// Server side: one state per send interval, each delayed by its own jitter and some lost. Later states never overtake earlier ones.
+		FRandomStream Random(4321);
+		TArray<FPacket> Trace;
+		float LastArrive = 0.0f;
+		for (float SendTime = 0.0f; SendTime < Duration; SendTime += SendInterval)
+		{
+			const float ArriveTime = FMath::Max(SendTime + Latency + Random.FRand() * MaxJitter, LastArrive);
+			LastArrive = ArriveTime;
+
+			if (Random.FRand() < DropChance)
+				continue;
+
+			FPacket& Packet = Trace.AddDefaulted_GetRef();
+			Packet.ArriveTime = ArriveTime;
+			Packet.Snapshot = GetPose(SendTime);
+		}
+
+		// Client side: a 60 Hz frame loop with a clock that already matches the server's
+		FMoveSnapshotBuffer Buffer;
+		int32 NextPacket = 0;
+		int32 Frames = 0;
+		int32 ExtrapolatedFrames = 0;
+		float MaxLocationError = 0.0f;
+		float MaxRotationError = 0.0f;
+		float MaxPitchError = 0.0f;
+		float LastRenderTime = -BIG_NUMBER;
+		bool IsRenderTimeMonotonic = true;
+
+		for (float Now = FrameTime; Now < Duration - 0.5f; Now += FrameTime)
+		{
+			while (NextPacket < Trace.Num() && Trace[NextPacket].ArriveTime <= Now)
+			{
+				// A character that only aims brings a new stamp and pitch but no movement, so only the first state is a full one
+				const FMoveSnapshotBuffer::FSnapshot& Snapshot = Trace[NextPacket].Snapshot;
+				if (IsAimOnly && Buffer.Num() > 0)
+				{
+					Buffer.AddPitch(Snapshot.ServerTime, Snapshot.Pitch, Now);
+				}
+				else
+				{
+					Buffer.Add(Snapshot, Now, 1000.0f);
+				}
+				++NextPacket;
+			}
+
+			if (Buffer.Num() == 0)
+				continue;
+
+			Buffer.UpdateDelay(FrameTime, 0.05f, 0.3f, 2.0f);
+
+			const float RenderTime = Now - Buffer.GetDelay();
+			FMoveSnapshotBuffer::FSnapshot Pose;
+			const bool IsExtrapolating = Buffer.Evaluate(RenderTime, 0.25f, Pose);
+
+			if (Now < WarmUp)
+				continue;
+
+			if (RenderTime <= LastRenderTime)
+			{
+				IsRenderTimeMonotonic = false;
+			}
+			LastRenderTime = RenderTime;
+
+			++Frames;
+			if (IsExtrapolating)
+			{
+				++ExtrapolatedFrames;
+				continue;
+			}
+
+			// Extrapolation holds rotation and aim by design, so only interpolated frames are held to the server path
+			const FMoveSnapshotBuffer::FSnapshot Truth = GetPose(RenderTime);
+			MaxLocationError = FMath::Max(MaxLocationError, FVector::Dist(Pose.Location, Truth.Location));
+			MaxRotationError = FMath::Max(MaxRotationError, FMath::RadiansToDegrees(Pose.Rotation.AngularDistance(Truth.Rotation)));
+			MaxPitchError = FMath::Max(MaxPitchError, FMath::Abs(FRotator::NormalizeAxis(Pose.Pitch - Truth.Pitch)));
+		}
+
+		Test.TestTrue(TEXT("Frames rendered"), Frames > 0);
+		Test.TestTrue(TEXT("Render time never runs backward"), IsRenderTimeMonotonic);
+		Test.TestTrue(FString::Printf(TEXT("Delay covers transit (delay %.3f, transit %.3f)"), Buffer.GetDelay(), Buffer.GetTransitTime()),
+			Buffer.GetDelay() > Buffer.GetTransitTime());
+		Test.TestTrue(FString::Printf(TEXT("Extrapolated at most 10%% of frames (%d of %d)"), ExtrapolatedFrames, Frames),
+			ExtrapolatedFrames * 10 <= Frames);
+		Test.TestTrue(FString::Printf(TEXT("Location within 2 uu of the server path (max %.3f)"), MaxLocationError), MaxLocationError < 2.0f);
+		Test.TestTrue(FString::Printf(TEXT("Rotation within 1.5 degrees (max %.3f)"), MaxRotationError), MaxRotationError < 1.5f);
+		Test.TestTrue(FString::Printf(TEXT("Pitch within 1 degree (max %.3f)"), MaxPitchError), MaxPitchError < 1.0f);
+	}
+}
+
+bool FSnapshotInterpolationJitterTest::RunTest(const FString& Parameters)
+{
+	SnapshotInterpolationTest::Replay(*this, &SnapshotInterpolationTest::GetTruePose, false);
+	return true;
+}
+
+bool FSnapshotInterpolationAimOnlyTest::RunTest(const FString& Parameters)
+{
+	// Standing still and aiming must not freeze the proxy's pitch
+	SnapshotInterpolationTest::Replay(*this, &SnapshotInterpolationTest::GetTrueAimOnlyPose, true);
+	return true;
+}
+
+#endif
@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "ShootingGameCharacter.h"
+#include "Weapon.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWeaponSpawnReadyTest, "ShootingGame.Weapon.SpawnReadyWithoutTick",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FWeaponSpawnReadyTest::RunTest(const FString& Parameters)
+{
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	AShootingGameCharacter* Char = World->SpawnActor<AShootingGameCharacter>();
+	AWeapon* Weapon = Char ? Char->SpawnWeapon(AWeapon::StaticClass()) : nullptr;
+	if (Weapon)
+	{
+		Char->SetEquipWeapon(Weapon);
+	}
+
+	// The world is never ticked, so anything that still waited on a timer or a later frame would fail here
+	TestNotNull(TEXT("Weapon spawned"), Weapon);
+	if (Weapon)
+	{
+		TestTrue(TEXT("OwnChar set before the first tick"), Weapon->OwnChar == Char);
+		TestTrue(TEXT("Instigator set before the first tick"), Weapon->GetInstigator() == Char);
+		TestTrue(TEXT("Attached to the character"), Weapon->GetAttachParentActor() == Char);
+		TestTrue(TEXT("Equipped"), Char->GetEquipWeapon() == Weapon);
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	return true;
+}
+
+#endif
@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VisibilityGridData.h"
+
+UVisibilityGridData::UVisibilityGridData()
+{
+	Origin = FVector2D::ZeroVector;
+	CellSize = 400.0f;
+	SizeX = 0;
+	SizeY = 0;
+	WordsPerCell = 0;
+}
+
+void UVisibilityGridData::Init(const FVector2D& InOrigin, float InCellSize, int32 InSizeX, int32 InSizeY)
+{
+	Origin = InOrigin;
+	CellSize = InCellSize;
+	SizeX = InSizeX;
+	SizeY = InSizeY;
+	WordsPerCell = (GetNumCells() + 31) / 32;
+
+	VisibleBits.Reset();
+	VisibleBits.AddZeroed(GetNumCells() * WordsPerCell);
+}
+
+FString UVisibilityGridData::GetPackageNameForMap(const FString& MapPackageName)
+{
+	return MapPackageName + TEXT("_VisibilityGrid");
+}
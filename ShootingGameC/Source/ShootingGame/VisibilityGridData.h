@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "VisibilityGridData.generated.h"
+
+/**
+ * Coarse potentially-visible set of a map, built offline by UBuildVisibilityGridCommandlet.
+ * The map is cut into square columns; each cell keeps one bit per cell it may see from any level and eye height in it.
+ * Positions outside the grid count as visible from everywhere.
+ */
+UCLASS(BlueprintType)
+class SHOOTINGGAME_API UVisibilityGridData : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UVisibilityGridData();
+
+	/** Cell containing Location, or INDEX_NONE outside the grid */
+	FORCEINLINE int32 GetCellIndex(const FVector& Location) const
+	{
+		const int32 x = FMath::FloorToInt((Location.X - Origin.X) / CellSize);
+		const int32 y = FMath::FloorToInt((Location.Y - Origin.Y) / CellSize);
+		if (x < 0 || y < 0 || x >= SizeX || y >= SizeY)
+			return INDEX_NONE;
+
+		return y * SizeX + x;
+	}
+
+	FORCEINLINE bool IsCellVisible(int32 From, int32 To) const
+	{
+		if (From == INDEX_NONE || To == INDEX_NONE)
+			return true;
+
+		return (VisibleBits[From * WordsPerCell + (To >> 5)] & (1u << (To & 31))) != 0;
+	}
+
+	FORCEINLINE bool IsVisible(const FVector& From, const FVector& To) const
+	{
+		return IsCellVisible(GetCellIndex(From), GetCellIndex(To));
+	}
+
+	FORCEINLINE int32 GetNumCells() const { return SizeX * SizeY; }
+
+	/** Sizes the grid and clears every bit */
+	void Init(const FVector2D& InOrigin, float InCellSize, int32 InSizeX, int32 InSizeY);
+
+	FORCEINLINE void SetCellVisible(int32 From, int32 To)
+	{
+		VisibleBits[From * WordsPerCell + (To >> 5)] |= 1u << (To & 31);
+	}
+
+	/** Row of From, WordsPerCell words long */
+	FORCEINLINE uint32* GetRow(int32 From) { return &VisibleBits[From * WordsPerCell]; }
+
+	FORCEINLINE int32 GetWordsPerCell() const { return WordsPerCell; }
+
+	/** Package the grid of the given map is saved to and loaded from, next to the map itself */
+	static FString GetPackageNameForMap(const FString& MapPackageName);
+
+public:
+	UPROPERTY(VisibleAnywhere, Category = "Visibility Grid")
+	FVector2D Origin;
+
+	UPROPERTY(VisibleAnywhere, Category = "Visibility Grid")
+	float CellSize;
+
+	UPROPERTY(VisibleAnywhere, Category = "Visibility Grid")
+	int32 SizeX;
+
+	UPROPERTY(VisibleAnywhere, Category = "Visibility Grid")
+	int32 SizeY;
+
+private:
+	UPROPERTY()
+	int32 WordsPerCell;
+
+	/** GetNumCells rows of WordsPerCell words */
+	UPROPERTY()
+	TArray<uint32> VisibleBits;
+};
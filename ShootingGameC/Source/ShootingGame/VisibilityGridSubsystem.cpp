@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VisibilityGridSubsystem.h"
+#include "ShootingGame.h"
+#include "VisibilityGridData.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/PackageName.h"
+
+static TAutoConsoleVariable<int32> CVarVisibilityCulling(
+	TEXT("sg.VisibilityCulling"),
+	1,
+	TEXT("Stop replicating characters the map's visibility grid hides from a connection.\n")
+	TEXT("0: distance relevancy only, 1: also cull by the visibility grid"));
+
+void UVisibilityGridSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Grid = nullptr;
+
+	// Only the server decides relevancy
+	UWorld* World = GetWorld();
+	if (World == nullptr || World->IsGameWorld() == false || IsRunningClientOnly())
+		return;
+
+	const FString MapPackageName = UWorld::RemovePIEPrefix(World->GetOutermost()->GetName());
+	const FString GridPackageName = UVisibilityGridData::GetPackageNameForMap(MapPackageName);
+	if (FPackageName::DoesPackageExist(GridPackageName) == false)
+		return;
+
+	const FString ObjectPath = GridPackageName + TEXT(".") + FPackageName::GetShortName(GridPackageName);
+	Grid = LoadObject<UVisibilityGridData>(nullptr, *ObjectPath);
+
+	if (Grid)
+	{
+		UE_LOG(LogShootingGame, Log, TEXT("Visibility grid %s: %d x %d cells of %.0f"), *ObjectPath, Grid->SizeX, Grid->SizeY, Grid->CellSize);
+	}
+}
+
+bool UVisibilityGridSubsystem::IsPotentiallyVisible(const FVector& From, const FVector& To) const
+{
+	if (Grid == nullptr || CVarVisibilityCulling.GetValueOnGameThread() == 0)
+		return true;
+
+	return Grid->IsVisible(From, To);
+}
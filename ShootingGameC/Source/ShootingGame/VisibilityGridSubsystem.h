@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "VisibilityGridSubsystem.generated.h"
+
+class UVisibilityGridData;
+
+/**
+ * Holds the visibility grid of the current map on the server, loaded from the package the build commandlet writes
+ * next to the map. Without a grid every position counts as visible.
+ */
+UCLASS()
+class SHOOTINGGAME_API UVisibilityGridSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** False only when the grid rules out any line of sight between the two cells */
+	bool IsPotentiallyVisible(const FVector& From, const FVector& To) const;
+
+	FORCEINLINE const UVisibilityGridData* GetGrid() const { return Grid; }
+
+private:
+	UPROPERTY()
+	UVisibilityGridData* Grid;
+};
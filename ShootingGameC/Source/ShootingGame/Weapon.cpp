@@ -6,8 +6,20 @@
 #include "Kismet/GameplayStatics.h"
 #include "DrawDebugHelpers.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "Components/AudioComponent.h"
 #include "ShootingGameHUD.h"
+#include "ExplosionSubsystem.h"
+#include "ProjectileSubsystem.h"
+#include "ShotResolutionSubsystem.h"
+#include "CosmeticEventSubsystem.h"
+#include "ShootingGameCharacter.h"
+#include "ShootingPlayerState.h"
+#include "ShootingGame.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+
+DECLARE_CYCLE_STAT(TEXT("Hitscan Trace"), STAT_HitscanTrace, STATGROUP_ShootingGame);
+DECLARE_CYCLE_STAT(TEXT("Penetration Trace"), STAT_PenetrationTrace, STATGROUP_ShootingGame);
 
 // Sets default values
 AWeapon::AWeapon()
@@ -25,19 +37,41 @@ AWeapon::AWeapon()
 	bReplicates = true;
 	SetReplicateMovement(true);
 
-	Ammo = 30;
+	MaxAmmo = 30;
+	Ammo = MaxAmmo;
+	UnclaimedShots = 0;
+
+	Damage = 10.0f;
+	ExplosionRadius = 0.0f;
+	ExplosionMinDamage = 0.0f;
+	ExplosionFalloff = 1.0f;
+	MaxShotOriginError = 500.0f;
+	MaxShotRange = 10000.0f;
+
+	ProjectileSpeed = 0.0f;
+	ProjectileGravityScale = 1.0f;
+	ProjectileSpread = 0.0f;
+	ProjectileLifetime = 3.0f;
+
+	PenetrationPower = 0.0f;
+	CharacterPenetrationCost = 20.0f;
+	DefaultPenetrationResistance = 1.0f;
 }
 
 void AWeapon::GetLifetimeReplicatedProps(TArray< FLifetimeProperty >& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(AWeapon, OwnChar);
-	DOREPLIFETIME(AWeapon, AnimMontage_Shoot);
-	DOREPLIFETIME(AWeapon, AnimMontage_Reload);
-	DOREPLIFETIME(AWeapon, FireEffect);
-	DOREPLIFETIME(AWeapon, SoundBase);
-	DOREPLIFETIME(AWeapon, Ammo);
+	FDoRepLifetimeParams PushParams;
+	PushParams.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(AWeapon, OwnChar, PushParams);
+	// Assets are fixed when the weapon spawns, so joining clients get them once and they are never compared again
+	DOREPLIFETIME_CONDITION(AWeapon, AnimMontage_Shoot, COND_InitialOnly);
+	DOREPLIFETIME_CONDITION(AWeapon, AnimMontage_Reload, COND_InitialOnly);
+	DOREPLIFETIME_CONDITION(AWeapon, FireEffect, COND_InitialOnly);
+	DOREPLIFETIME_CONDITION(AWeapon, SoundBase, COND_InitialOnly);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AWeapon, Ammo, PushParams);
 }
 
 // Called when the game starts or when spawned
@@ -46,6 +80,12 @@ void AWeapon::BeginPlay()
 	Super::BeginPlay();
 	
 	Audio->SetSound(SoundBase);
+
+	PenetrationResistance.Reset();
+	for (const FPenetrationMaterial& Entry : PenetrationMaterials)
+	{
+		PenetrationResistance.Add(Entry.Material, Entry.Resistance);
+	}
 }
 
 // Called every frame
@@ -55,6 +95,28 @@ void AWeapon::Tick(float DeltaTime)
 
 }
 
+float AWeapon::GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth)
+{
+	// A weapon is exactly as urgent as the character holding it
+	if (IsValid(OwnChar))
+	{
+		return OwnChar->GetNetPriority(ViewPos, ViewDir, Viewer, ViewTarget, InChannel, Time, bLowBandwidth);
+	}
+
+	return Super::GetNetPriority(ViewPos, ViewDir, Viewer, ViewTarget, InChannel, Time, bLowBandwidth);
+}
+
+bool AWeapon::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	// Likewise relevant exactly when its character is, so a character hidden by the visibility grid does not leak through its weapon
+	if (IsValid(OwnChar))
+	{
+		return OwnChar->IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation);
+	}
+
+	return Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation);
+}
+
 void AWeapon::PressTrigger_Implementation()
 {
 	OwnChar->PlayAnimMontage(AnimMontage_Shoot);
@@ -62,9 +124,14 @@ void AWeapon::PressTrigger_Implementation()
 
 void AWeapon::NotifyShoot_Implementation()
 {
-	UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), FireEffect, Mesh->GetSocketLocation("Muzzle"), Mesh->GetSocketRotation("Muzzle"), FVector(0.3f, 0.3f, 0.3f));
+	// Cosmetics only; a dedicated server would create and collect a component per shot for nothing
+	if (GetNetMode() != NM_DedicatedServer)
+	{
+		// Pooled so firing reuses finished muzzle flash components instead of leaving one to the GC per shot
+		UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), FireEffect, Mesh->GetSocketLocation("Muzzle"), Mesh->GetSocketRotation("Muzzle"), FVector(0.3f, 0.3f, 0.3f), true, EPSCPoolMethod::AutoRelease);
 
-	Audio->Play();
+		Audio->Play();
+	}
 
 	APlayerController* shooter = GetWorld()->GetFirstPlayerController();
 	if (shooter == OwnChar->GetController())
@@ -72,8 +139,24 @@ void AWeapon::NotifyShoot_Implementation()
 		FVector forward = shooter->PlayerCameraManager->GetActorForwardVector();
 
 		FVector start = (forward * 350) + shooter->PlayerCameraManager->GetCameraLocation();
+
+		if (ProjectileSpeed > 0.0f)
+		{
+			UProjectileSubsystem* Projectiles = GetWorld()->GetSubsystem<UProjectileSubsystem>();
+			int32 Seed = FMath::Rand();
+			float ServerTime = (float)Projectiles->GetServerTime();
+
+			// The shooter simulates its own projectile right away; the server and other clients start theirs from the event
+			if (HasAuthority() == false)
+			{
+				Projectiles->SpawnProjectile(this, start, forward, Seed, ServerTime);
+			}
+			ReqFireProjectile(start, forward, Seed, ServerTime);
+			return;
+		}
+
 		FVector end = (forward * 5000) + shooter->PlayerCameraManager->GetCameraLocation();
-		GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Yellow, FString::Printf(TEXT("Client - ReqShoot")));
+		SHOOTING_DEBUG_MESSAGE(TEXT("Client - ReqShoot"));
 		ReqShoot(start, end);
 	}
 }
@@ -91,9 +174,14 @@ void AWeapon::IsCanUse_Implementation(bool& IsCanUse)
 		return;
 	}
 
-	Ammo = Ammo - 1;
 	IsCanUse = true;
-	OnRep_Ammo();
+	SetAmmo(Ammo - 1);
+
+	// The owning client claims this shot with ReqFireProjectile once the fire montage reaches its notify
+	if (HasAuthority())
+	{
+		UnclaimedShots = FMath::Min(UnclaimedShots + 1, MaxAmmo);
+	}
 }
 
 void AWeapon::OnRep_Ammo()
@@ -101,9 +189,17 @@ void AWeapon::OnRep_Ammo()
 	UpdateAmmoToHud();
 }
 
+void AWeapon::OnRep_OwnChar()
+{
+	UpdateAmmoToHud();
+}
+
 void AWeapon::UpdateAmmoToHud()
 {
 	//UI  
+	if (IsValid(OwnChar) == false)
+		return;
+
 	APlayerController* firstPlayer = GetWorld()->GetFirstPlayerController();
 
 	if (OwnChar->GetController() == firstPlayer)
@@ -111,27 +207,212 @@ void AWeapon::UpdateAmmoToHud()
 		AShootingGameHUD* Hud = Cast<AShootingGameHUD>(firstPlayer->GetHUD());
 		if (IsValid(Hud))
 		{
+			Hud->OnLocalWeaponReady();
 			Hud->OnUpdateMyAmmo(Ammo);
 		}
 	}
 }
 
+void AWeapon::ResetAmmo()
+{
+	SetAmmo(MaxAmmo);
+}
+
+void AWeapon::AddAmmo(int Amount)
+{
+	SetAmmo(Ammo + Amount);
+}
+
+void AWeapon::SetAmmo(int NewAmmo)
+{
+	FlushNetDormancy();
+
+	Ammo = NewAmmo;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AWeapon, Ammo, this);
+
+	OnRep_Ammo();
+}
+
+void AWeapon::SetOwnChar(ACharacter* NewOwnChar)
+{
+	FlushNetDormancy();
+
+	OwnChar = NewOwnChar;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AWeapon, OwnChar, this);
+}
+
+void AWeapon::ReqFireProjectile_Implementation(const FVector_NetQuantize vStart, const FVector_NetQuantizeNormal vDir, int32 Seed, float ServerTime)
+{
+	// Same origin check as ResolveShot, and only for a shot the server itself allowed
+	if (IsValid(OwnChar) == false || UnclaimedShots <= 0 ||
+		FVector::DistSquared(vStart, OwnChar->GetActorLocation()) > FMath::Square(MaxShotOriginError))
+	{
+		SHOOTING_DEBUG_MESSAGE(TEXT("Server - ReqFireProjectile rejected"));
+		return;
+	}
+
+	--UnclaimedShots;
+
+	UProjectileSubsystem* Projectiles = GetWorld()->GetSubsystem<UProjectileSubsystem>();
+	Projectiles->SpawnProjectile(this, vStart, vDir, Seed, ServerTime);
+
+	ResFireProjectile(vStart, vDir, Seed, ServerTime);
+}
+
+void AWeapon::ResFireProjectile_Implementation(const FVector_NetQuantize vStart, const FVector_NetQuantizeNormal vDir, int32 Seed, float ServerTime)
+{
+	// The server already simulates it and the shooter spawned its own copy when firing
+	if (HasAuthority() || (IsValid(OwnChar) && OwnChar->IsLocallyControlled()))
+		return;
+
+	UProjectileSubsystem* Projectiles = GetWorld()->GetSubsystem<UProjectileSubsystem>();
+	Projectiles->SpawnProjectile(this, vStart, vDir, Seed, ServerTime);
+}
+
 void AWeapon::ReqShoot_Implementation(const FVector vStart, const FVector vEnd)
 {
-	FHitResult result;
-	bool isHit = GetWorld()->LineTraceSingleByObjectType(result, vStart, vEnd, ECollisionChannel::ECC_Pawn);
+	GetWorld()->GetSubsystem<UShotResolutionSubsystem>()->QueueShot(this, vStart, vEnd);
+}
+
+void AWeapon::ResolveShot(const FVector& vStart, const FVector& vEnd, FShotResult& Out) const
+{
+	if (IsValid(OwnChar) == false)
+		return;
+
+	if (FVector::DistSquared(vStart, OwnChar->GetActorLocation()) > FMath::Square(MaxShotOriginError) ||
+		FVector::DistSquared(vStart, vEnd) > FMath::Square(MaxShotRange))
+		return;
+
+	Out.IsValid = true;
+
+	if (ExplosionRadius > 0.0f)
+	{
+		FCollisionObjectQueryParams ObjectParams(ECC_TO_BITFIELD(ECC_Pawn) | ECC_TO_BITFIELD(ECC_WorldStatic) | ECC_TO_BITFIELD(ECC_WorldDynamic));
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(WeaponShoot), false, this);
+
+		Out.IsHit = GetWorld()->LineTraceSingleByObjectType(Out.Hit, vStart, vEnd, ObjectParams, QueryParams);
+		return;
+	}
+
+	if (PenetrationPower > 0.0f)
+	{
+		TracePenetration(vStart, vEnd, Out.Scratch, Out.Victims);
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_HitscanTrace);
+	Out.IsHit = GetWorld()->LineTraceSingleByObjectType(Out.Hit, vStart, vEnd, ECollisionChannel::ECC_Pawn);
+}
+
+void AWeapon::ApplyShot(const FVector& vStart, const FVector& vEnd, const FShotResult& Result)
+{
+	if (ExplosionRadius > 0.0f)
+	{
+		UExplosionSubsystem* Explosions = GetWorld()->GetSubsystem<UExplosionSubsystem>();
+		Explosions->QueueExplosion(Result.IsHit ? Result.Hit.ImpactPoint : vEnd, ExplosionRadius, Damage, ExplosionMinDamage, ExplosionFalloff, OwnChar->GetController(), this);
+		return;
+	}
+
+	AController* EventInstigator = OwnChar->GetController();
+	const uint32 DamageMask = AShootingPlayerState::GetDamageMask(EventInstigator);
+
+	if (PenetrationPower > 0.0f)
+	{
+		DrawDebugLine(GetWorld(), vStart, vEnd, FColor::Orange, false, 5.0f);
+
+		for (const FPenetrationVictim& Victim : Result.Victims)
+		{
+			AShootingGameCharacter* VictimChar = Cast<AShootingGameCharacter>(Victim.Victim);
+			if (VictimChar && VictimChar->CanBeDamagedBy(EventInstigator, DamageMask) == false)
+				continue;
+
+			UGameplayStatics::ApplyDamage(Victim.Victim, Victim.Damage, EventInstigator, this, UDamageType::StaticClass());
+
+			if (VictimChar)
+			{
+				GetWorld()->GetSubsystem<UCosmeticEventSubsystem>()->QueueEvent(ECosmeticEventType::HitImpact, VictimChar, Victim.ImpactPoint, Victim.ImpactNormal);
+			}
+		}
+		return;
+	}
 
 	DrawDebugLine(GetWorld(), vStart, vEnd, FColor::Yellow, false, 5.0f);
 
-	GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Yellow, FString::Printf(TEXT("Server - ReqShoot")));
+	SHOOTING_DEBUG_MESSAGE(TEXT("Server - ReqShoot"));
 
-	if (isHit)
+	if (Result.IsHit)
 	{
-		ACharacter* HitChar = Cast<ACharacter>(result.GetActor());
+		ACharacter* HitChar = Cast<ACharacter>(Result.Hit.GetActor());
+		AShootingGameCharacter* HitShooter = Cast<AShootingGameCharacter>(HitChar);
+		if (HitShooter && HitShooter->CanBeDamagedBy(EventInstigator, DamageMask) == false)
+			return;
+
 		if (HitChar)
 		{
-			UGameplayStatics::ApplyDamage(HitChar, 10, OwnChar->GetController(), this, UDamageType::StaticClass());
+			UGameplayStatics::ApplyDamage(HitChar, Damage, EventInstigator, this, UDamageType::StaticClass());
+
+			if (HitShooter)
+			{
+				GetWorld()->GetSubsystem<UCosmeticEventSubsystem>()->QueueEvent(ECosmeticEventType::HitImpact, HitShooter, Result.Hit.ImpactPoint, Result.Hit.ImpactNormal);
+			}
 		}
 	}
 }
 
+void AWeapon::TracePenetration(const FVector& vStart, const FVector& vEnd, FPenetrationScratch& Scratch, TArray<FPenetrationVictim>& OutVictims) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_PenetrationTrace);
+
+	FCollisionObjectQueryParams ObjectParams(ECC_TO_BITFIELD(ECC_Pawn) | ECC_TO_BITFIELD(ECC_WorldStatic) | ECC_TO_BITFIELD(ECC_WorldDynamic));
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(WeaponPenetration), false, this);
+	QueryParams.bReturnPhysicalMaterial = true;
+	QueryParams.AddIgnoredActor(OwnChar);
+
+	// Two traces per shot regardless of how many surfaces it crosses: entries going forward, exits coming back
+	TArray<FHitResult>& Entries = Scratch.Entries;
+	TArray<FHitResult>& Exits = Scratch.Exits;
+	Entries.Reset();
+	Exits.Reset();
+	GetWorld()->LineTraceMultiByObjectType(Entries, vStart, vEnd, ObjectParams, QueryParams);
+	if (Entries.Num() == 0)
+		return;
+	GetWorld()->LineTraceMultiByObjectType(Exits, vEnd, vStart, ObjectParams, QueryParams);
+
+	const FVector Dir = (vEnd - vStart).GetSafeNormal();
+	const float Length = FVector::Dist(vStart, vEnd);
+	float Power = PenetrationPower;
+
+	for (const FHitResult& Entry : Entries)
+	{
+		const float EntryDist = (Entry.ImpactPoint - vStart) | Dir;
+
+		ACharacter* HitChar = Cast<ACharacter>(Entry.GetActor());
+		if (HitChar)
+		{
+			if (OutVictims.ContainsByPredicate([HitChar](const FPenetrationVictim& Victim) { return Victim.Victim == HitChar; }))
+				continue;
+
+			OutVictims.Add({ HitChar, Damage * (Power / PenetrationPower), Entry.ImpactPoint, Entry.ImpactNormal });
+			Power -= CharacterPenetrationCost;
+		}
+		else
+		{
+			// The exit is the nearest backward hit on the same component beyond the entry
+			float ExitDist = Length;
+			for (const FHitResult& Exit : Exits)
+			{
+				const float Dist = (Exit.ImpactPoint - vStart) | Dir;
+				if (Exit.Component == Entry.Component && Dist > EntryDist && Dist < ExitDist)
+				{
+					ExitDist = Dist;
+				}
+			}
+
+			const float* Resistance = PenetrationResistance.Find(Entry.PhysMaterial.Get());
+			Power -= (ExitDist - EntryDist) * (Resistance ? *Resistance : DefaultPenetrationResistance);
+		}
+
+		if (Power <= 0.0f)
+			break;
+	}
+}
@@ -7,6 +7,36 @@
 #include "GameFramework/Actor.h"
 #include "Weapon.generated.h"
 
+/** How hard a physical material is to shoot through */
+USTRUCT(BlueprintType)
+struct FPenetrationMaterial
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	class UPhysicalMaterial* Material = nullptr;
+
+	/** Penetration power consumed per centimeter of this material */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float Resistance = 1.0f;
+};
+
+/** A character struck by a penetrating shot and the damage left when the round reached it */
+struct FPenetrationVictim
+{
+	ACharacter* Victim;
+	float Damage;
+	FVector ImpactPoint;
+	FVector ImpactNormal;
+};
+
+/** Hit buffers for TracePenetration, owned by the caller so they can be reused from shot to shot */
+struct FPenetrationScratch
+{
+	TArray<FHitResult> Entries;
+	TArray<FHitResult> Exits;
+};
+
 UCLASS()
 class SHOOTINGGAME_API AWeapon : public AActor, public IWeaponInterface
 {
@@ -24,6 +54,10 @@ public:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	virtual float GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth) override;
+
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
 public:
 	UFUNCTION(BlueprintNativeEvent, BlueprintCallable)
 	void PressTrigger();
@@ -49,12 +83,46 @@ public:
 	UFUNCTION(Server, Reliable)
 	void ReqShoot(const FVector vStart, const FVector vEnd);
 
+	UFUNCTION(Server, Reliable)
+	void ReqFireProjectile(const FVector_NetQuantize vStart, const FVector_NetQuantizeNormal vDir, int32 Seed, float ServerTime);
+
+	UFUNCTION(NetMulticast, Unreliable)
+	void ResFireProjectile(const FVector_NetQuantize vStart, const FVector_NetQuantizeNormal vDir, int32 Seed, float ServerTime);
+
+	/** Called on every machine where a projectile of this weapon stops, for impact effects */
+	UFUNCTION(BlueprintImplementableEvent)
+	void OnProjectileImpact(const FVector& Location, const FVector& Normal);
+
 	UFUNCTION()
 	void OnRep_Ammo();
 
+	UFUNCTION()
+	void OnRep_OwnChar();
+
 	UFUNCTION(BlueprintCallable)
 	void UpdateAmmoToHud();
 
+	UFUNCTION(BlueprintCallable)
+	void ResetAmmo();
+
+	UFUNCTION(BlueprintCallable)
+	void AddAmmo(int Amount);
+
+	UFUNCTION(BlueprintCallable)
+	void SetAmmo(int NewAmmo);
+
+	UFUNCTION(BlueprintSetter)
+	void SetOwnChar(ACharacter* NewOwnChar);
+
+	/** Traces vStart to vEnd through walls and characters until PenetrationPower runs out. Does not apply damage. */
+	void TracePenetration(const FVector& vStart, const FVector& vEnd, FPenetrationScratch& Scratch, TArray<FPenetrationVictim>& OutVictims) const;
+
+	/** Validates a hitscan shot and runs its scene queries. Has no side effects, so it may run on a worker thread. */
+	void ResolveShot(const FVector& vStart, const FVector& vEnd, struct FShotResult& Out) const;
+
+	/** Game thread: applies the damage, explosion and debug output of a resolved shot */
+	void ApplyShot(const FVector& vStart, const FVector& vEnd, const struct FShotResult& Result);
+
 public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	UStaticMeshComponent* Mesh;
@@ -62,7 +130,8 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	UAudioComponent* Audio;
 
-	UPROPERTY(Replicated, BlueprintReadWrite, Meta = (ExposeOnSpawn = "true"))
+	/** Blueprint writes, including the spawn pin, go through SetOwnChar so the push model sees them */
+	UPROPERTY(ReplicatedUsing = OnRep_OwnChar, BlueprintReadOnly, BlueprintSetter = SetOwnChar, Meta = (ExposeOnSpawn = "true"))
 	ACharacter* OwnChar;
 
 	UPROPERTY(Replicated, BlueprintReadWrite, Meta = (ExposeOnSpawn = "true"))
@@ -79,4 +148,63 @@ public:
 
 	UPROPERTY(ReplicatedUsing = OnRep_Ammo)
 	int Ammo;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int MaxAmmo;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Damage)
+	float Damage;
+
+	/** When above zero, shots explode at the impact point instead of damaging the hit character directly */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Damage)
+	float ExplosionRadius;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Damage)
+	float ExplosionMinDamage;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Damage)
+	float ExplosionFalloff;
+
+	/** Shots starting farther than this from the owner are rejected by the server */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Damage)
+	float MaxShotOriginError;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Damage)
+	float MaxShotRange;
+
+	/** When above zero, hitscan shots pass through surfaces and characters until this much power is spent */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Penetration)
+	float PenetrationPower;
+
+	/** Power spent passing through a character */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Penetration)
+	float CharacterPenetrationCost;
+
+	/** Resistance for materials missing from PenetrationMaterials */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Penetration)
+	float DefaultPenetrationResistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Penetration)
+	TArray<FPenetrationMaterial> PenetrationMaterials;
+
+	/** When above zero, shots are simulated as ballistic projectiles instead of instant traces */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Projectile)
+	float ProjectileSpeed;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Projectile)
+	float ProjectileGravityScale;
+
+	/** Half angle of the spread cone, in degrees */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Projectile)
+	float ProjectileSpread;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Projectile)
+	float ProjectileLifetime;
+
+private:
+	/** PenetrationMaterials flattened at BeginPlay so a shot does one hash lookup per surface */
+	TMap<const class UPhysicalMaterial*, float> PenetrationResistance;
+
+	/** Server: shots IsCanUse granted that no ReqFireProjectile has claimed yet */
+	int32 UnclaimedShots;
 };
@@ -0,0 +1,180 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WeaponInventoryComponent.h"
+#include "ShootingGame.h"
+#include "ShootingGameCharacter.h"
+#include "Weapon.h"
+#include "Net/UnrealNetwork.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Actor Spawns"), STAT_WeaponActorSpawns, STATGROUP_ShootingGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Swaps"), STAT_WeaponSwaps, STATGROUP_ShootingGame);
+
+UWeaponInventoryComponent::UWeaponInventoryComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	SetIsReplicatedByDefault(true);
+
+	EquippedSlot = INDEX_NONE;
+}
+
+void UWeaponInventoryComponent::GetLifetimeReplicatedProps(TArray< FLifetimeProperty >& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(UWeaponInventoryComponent, Weapons);
+	DOREPLIFETIME(UWeaponInventoryComponent, EquippedSlot);
+}
+
+void UWeaponInventoryComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (GetOwnerRole() != ROLE_Authority)
+		return;
+
+	for (int32 i = 0; i < WeaponDefinitions.Num(); ++i)
+	{
+		if (WeaponDefinitions[i])
+		{
+			AddWeapon(i, WeaponDefinitions[i]->GetDefaultObject<AWeapon>()->MaxAmmo);
+		}
+	}
+}
+
+bool UWeaponInventoryComponent::AddWeapon(uint8 DefinitionId, int32 Ammo)
+{
+	if (GetOwnerRole() != ROLE_Authority || WeaponDefinitions.IsValidIndex(DefinitionId) == false || WeaponDefinitions[DefinitionId] == nullptr)
+		return false;
+
+	for (int32 Slot = 0; Slot < Weapons.Items.Num(); ++Slot)
+	{
+		FWeaponInstance& Item = Weapons.Items[Slot];
+		if (Item.DefinitionId != DefinitionId)
+			continue;
+
+		// The equipped weapon's ammo lives on its actor and overwrites the instance on the next swap
+		AShootingGameCharacter* Char = Cast<AShootingGameCharacter>(GetOwner());
+		AWeapon* Current = Char ? Cast<AWeapon>(Char->GetEquipWeapon()) : nullptr;
+		if (Slot == EquippedSlot && Current)
+		{
+			Current->SetAmmo(Current->Ammo + Ammo);
+			return true;
+		}
+
+		Item.Ammo += Ammo;
+		Weapons.MarkItemDirty(Item);
+		return true;
+	}
+
+	FWeaponInstance& Item = Weapons.Items.AddDefaulted_GetRef();
+	Item.DefinitionId = DefinitionId;
+	Item.Ammo = Ammo;
+	Weapons.MarkItemDirty(Item);
+	return true;
+}
+
+void UWeaponInventoryComponent::ResetAmmo()
+{
+	if (GetOwnerRole() != ROLE_Authority)
+		return;
+
+	for (FWeaponInstance& Item : Weapons.Items)
+	{
+		Item.Ammo = WeaponDefinitions[Item.DefinitionId]->GetDefaultObject<AWeapon>()->MaxAmmo;
+		Weapons.MarkItemDirty(Item);
+	}
+}
+
+void UWeaponInventoryComponent::EquipSlot(int32 Slot)
+{
+	if (GetOwnerRole() != ROLE_Authority)
+	{
+		ReqEquipSlot(Slot);
+		return;
+	}
+
+	AShootingGameCharacter* Char = Cast<AShootingGameCharacter>(GetOwner());
+	if (Char == nullptr || Weapons.Items.IsValidIndex(Slot) == false)
+		return;
+
+	AWeapon* Current = Cast<AWeapon>(Char->GetEquipWeapon());
+	if (Current && Weapons.Items.IsValidIndex(EquippedSlot))
+	{
+		if (Slot == EquippedSlot)
+			return;
+
+		// Ammo only lives on the instance while it is holstered, so a swap is the one delta sent for it
+		FWeaponInstance& Holstered = Weapons.Items[EquippedSlot];
+		Holstered.Ammo = Current->Ammo;
+		Weapons.MarkItemDirty(Holstered);
+
+		Char->SetEquipWeapon(nullptr);
+		ReleaseWeaponActor(Current);
+	}
+
+	const FWeaponInstance& Item = Weapons.Items[Slot];
+	AWeapon* Weapon = AcquireWeaponActor(Item.DefinitionId);
+	if (Weapon == nullptr)
+		return;
+
+	Weapon->SetAmmo(Item.Ammo);
+
+	EquippedSlot = Slot;
+	Char->SetEquipWeapon(Weapon);
+
+	INC_DWORD_STAT(STAT_WeaponSwaps);
+}
+
+void UWeaponInventoryComponent::EquipNext()
+{
+	if (Weapons.Items.Num() <= 1)
+		return;
+
+	EquipSlot((EquippedSlot + 1) % Weapons.Items.Num());
+}
+
+bool UWeaponInventoryComponent::ReqEquipSlot_Validate(int32 Slot)
+{
+	// Every definition is carried at most once, so no honest client can name a slot past them
+	return Slot >= 0 && Slot < WeaponDefinitions.Num();
+}
+
+void UWeaponInventoryComponent::ReqEquipSlot_Implementation(int32 Slot)
+{
+	EquipSlot(Slot);
+}
+
+AWeapon* UWeaponInventoryComponent::AcquireWeaponActor(uint8 DefinitionId)
+{
+	UClass* WeaponClass = WeaponDefinitions[DefinitionId];
+
+	for (int32 i = 0; i < WeaponPool.Num(); ++i)
+	{
+		AWeapon* Weapon = WeaponPool[i];
+		if (IsValid(Weapon) && Weapon->GetClass() == WeaponClass)
+		{
+			WeaponPool.RemoveAtSwap(i, 1, false);
+
+			Weapon->SetNetDormancy(DORM_Awake);
+			Weapon->SetActorHiddenInGame(false);
+			Weapon->SetActorEnableCollision(true);
+			return Weapon;
+		}
+	}
+
+	AShootingGameCharacter* Char = Cast<AShootingGameCharacter>(GetOwner());
+	INC_DWORD_STAT(STAT_WeaponActorSpawns);
+
+	return Char->SpawnWeapon(WeaponDefinitions[DefinitionId]);
+}
+
+void UWeaponInventoryComponent::ReleaseWeaponActor(AWeapon* Weapon)
+{
+	Weapon->FlushNetDormancy();
+	Weapon->SetActorHiddenInGame(true);
+	Weapon->SetActorEnableCollision(false);
+
+	WeaponPool.Push(Weapon);
+}
@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Engine/NetSerialization.h"
+#include "WeaponInventoryComponent.generated.h"
+
+class AWeapon;
+class UWeaponInventoryComponent;
+
+/** A weapon the character carries. Only the equipped one exists as an actor. */
+USTRUCT(BlueprintType)
+struct FWeaponInstance : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	/** Index into UWeaponInventoryComponent::WeaponDefinitions */
+	UPROPERTY(BlueprintReadOnly)
+	uint8 DefinitionId = 0;
+
+	/** One bit per attachment slot */
+	UPROPERTY(BlueprintReadOnly)
+	uint8 Attachments = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 Ammo = 0;
+};
+
+USTRUCT()
+struct FWeaponInstanceArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FWeaponInstance> Items;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FWeaponInstance, FWeaponInstanceArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FWeaponInstanceArray> : public TStructOpsTypeTraitsBase2<FWeaponInstanceArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class SHOOTINGGAME_API UWeaponInventoryComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UWeaponInventoryComponent();
+
+protected:
+	virtual void BeginPlay() override;
+
+public:
+	UFUNCTION(BlueprintPure)
+	FORCEINLINE bool HasWeapons() const { return Weapons.Items.Num() > 0; }
+
+	UFUNCTION(BlueprintPure)
+	FORCEINLINE int32 GetEquippedSlot() const { return EquippedSlot; }
+
+	UFUNCTION(BlueprintPure)
+	FORCEINLINE int32 GetNumWeapons() const { return Weapons.Items.Num(); }
+
+	/** Adds a weapon of the given definition, or only its ammo if one is already carried. Server only; false if nothing was granted. */
+	UFUNCTION(BlueprintCallable)
+	bool AddWeapon(uint8 DefinitionId, int32 Ammo);
+
+	/** Refills every carried weapon. Server only. */
+	UFUNCTION(BlueprintCallable)
+	void ResetAmmo();
+
+	/** Materializes the weapon in Slot and equips it on the owning character. */
+	UFUNCTION(BlueprintCallable)
+	void EquipSlot(int32 Slot);
+
+	UFUNCTION(BlueprintCallable)
+	void EquipNext();
+
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ReqEquipSlot(int32 Slot);
+
+public:
+	/** Weapon classes referenced by FWeaponInstance::DefinitionId. Every entry is granted on BeginPlay. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Inventory)
+	TArray<TSubclassOf<AWeapon>> WeaponDefinitions;
+
+private:
+	AWeapon* AcquireWeaponActor(uint8 DefinitionId);
+
+	void ReleaseWeaponActor(AWeapon* Weapon);
+
+	UPROPERTY(Replicated)
+	FWeaponInstanceArray Weapons;
+
+	UPROPERTY(Replicated)
+	int8 EquippedSlot;
+
+	/** Hidden weapon actors kept by the server so swapping back does not spawn again */
+	UPROPERTY()
+	TArray<AWeapon*> WeaponPool;
+};